@@ -0,0 +1,47 @@
+/*
+Sample both encoders in the background and compute the wheel speeds from uniform samples.
+
+ENCODER_SamplerStart() reads the two LS7366 counters from the Timer5 compare C interrupt at
+SAMPLE_FREQUENCY. loop() never waits on SPI for them, it drains the samples that piled up since
+its last pass. Each sample carries the micros() of its latch, so the speed uses the real interval.
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+
+#define SAMPLE_FREQUENCY 500
+#define PRINT_PERIOD 200 // ms
+
+EncoderCounts last;
+bool started = false;
+float leftSpeed = 0;  // ticks per second
+float rightSpeed = 0;
+unsigned long lastPrint = 0;
+
+void setup() {
+  BoardInit();
+  MOTOR_SetSpeed(LEFT, 0.3);
+  MOTOR_SetSpeed(RIGHT, 0.3);
+  ENCODER_SamplerStart(SAMPLE_FREQUENCY);
+}
+
+void loop() {
+  EncoderCounts sample;
+  while (ENCODER_SamplerRead(sample)) {
+    if (started) {
+      float dt = (sample.timestamp - last.timestamp) / 1000000.0;
+      leftSpeed = LS7366Counter::delta(sample.left, last.left) / dt;
+      rightSpeed = LS7366Counter::delta(sample.right, last.right) / dt;
+    }
+    last = sample;
+    started = true;
+  }
+
+  if (millis() - lastPrint >= PRINT_PERIOD) {
+    lastPrint = millis();
+    Serial.print(leftSpeed);
+    Serial.print(' ');
+    Serial.print(rightSpeed);
+    Serial.print(" dropped ");
+    Serial.println(ENCODER_SamplerDropped());
+  }
+}
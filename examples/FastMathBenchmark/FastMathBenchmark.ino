@@ -0,0 +1,75 @@
+/*
+Compare the cost of the FastMath kernels with the avr-libc functions they replace.
+
+Each kernel runs BENCHMARK_ITERATION times on changing inputs. The result is printed in
+microseconds and CPU cycles per call, loop overhead included.
+
+Build RobusPosition with -D ROBUS_POSITION_FAST_MATH to use the kernels in the odometry and the follower.
+*/
+#include <Arduino.h>
+#include <FastMath.h>
+
+#define BENCHMARK_ITERATION 1000
+
+using namespace FastMath;
+
+volatile float inputAngle = 0.7;
+volatile float inputX = 1.5;
+volatile float inputY = -0.3;
+
+volatile float sink;
+
+void report(const char *name, unsigned long elapsed) {
+  float us = (float) elapsed / BENCHMARK_ITERATION;
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us);
+  Serial.print(" us, ");
+  Serial.print((unsigned long) (us * (F_CPU / 1000000UL)));
+  Serial.println(" cycles per call");
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  unsigned long start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = sin(inputAngle + i * 0.01f);
+  }
+  report("sin", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = fastSin(inputAngle + i * 0.01f);
+  }
+  report("fastSin", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = atan2(inputY + i * 0.01f, inputX);
+  }
+  report("atan2", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = fastAtan2(inputY + i * 0.01f, inputX);
+  }
+  report("fastAtan2", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    float x = inputX;
+    float y = inputY + i * 0.01f;
+    sink = sqrt(x * x + y * y);
+  }
+  report("sqrt", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = fastHypot(inputX, inputY + i * 0.01f);
+  }
+  report("fastHypot", micros() - start);
+}
+
+void loop() {
+}
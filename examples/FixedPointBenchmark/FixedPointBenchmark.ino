@@ -0,0 +1,115 @@
+/*
+Measure the cost of RobusPosition::update() in the engine this build selects.
+
+The update runs for real, through the PositionOdometry and PositionFollower of RobusPosition,
+with the robot standing still: the follow velocity is zero and the waypoints are out of reach,
+so the pure pursuit runs every tick without moving the wheels. The RobusMovement calls the
+update makes are timed alone and subtracted, what is left is the odometry and the follower.
+The result is printed in microseconds and CPU cycles per tick, then the cost of a lone division.
+
+Flash it twice, once as is and once with -D ROBUS_POSITION_FIXED_POINT in build_flags, to compare
+the float and Q16.16 engines. With -D FIXED_POINT_COUNT_CONVERSIONS as well, it also prints the
+float to Q16.16 conversions left per tick at the float API and the pose snapshot; the counting
+slows the update down, so take the timings from a build without it.
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+#include <RobusPosition.h>
+
+#define BENCHMARK_ITERATION 1000
+#define BENCHMARK_PERIOD 10000 // Microseconds between two updates, as seen by RobusPosition
+
+using namespace FixedPoint;
+
+volatile float inputVelocity = 0.25;
+volatile float inputTargetX = 1.5;
+
+volatile float floatSink;
+volatile int32_t fixedSink;
+
+unsigned long benchmarkTime = 0;
+
+unsigned long benchmarkClock() {
+  return benchmarkTime;
+}
+
+void positionUpdate() {
+  benchmarkTime += BENCHMARK_PERIOD;
+  RobusPosition::update();
+}
+
+void movementCalls() {
+  // The same RobusMovement calls as one update.
+  floatSink = RobusMovement::getVelocity() + RobusMovement::getAngularVelocity() + RobusMovement::computeOrientation();
+  RobusMovement::setVelocity(0);
+  RobusMovement::setAngularVelocity(0);
+  RobusMovement::update();
+}
+
+void floatDivision() {
+  floatSink = inputTargetX / inputVelocity;
+}
+
+void fixedDivision() {
+  fixedSink = (Fixed(inputTargetX) / Fixed(inputVelocity)).raw;
+}
+
+void report(const char *name, float us) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us);
+  Serial.print(" us, ");
+  Serial.print((unsigned long) (us * (F_CPU / 1000000UL)));
+  Serial.println(" cycles per call");
+}
+
+float measure(void (*kernel)()) {
+  unsigned long start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    kernel();
+  }
+  return (float) (micros() - start) / BENCHMARK_ITERATION;
+}
+
+void setup() {
+  BoardInit();
+  Serial.begin(9600);
+
+  RobusPosition::setClock(benchmarkClock);
+  RobusPosition::setPosition(0, 0);
+  RobusPosition::setFollowVelocity(0);
+  RobusPosition::clearWaypoints();
+  RobusPosition::addWaypoint(100, 0);
+  RobusPosition::addWaypoint(100, 100);
+  RobusPosition::startFollowingTarget();
+  positionUpdate();
+
+#ifdef ROBUS_POSITION_FIXED_POINT
+  Serial.println("engine: Q16.16");
+#else
+  Serial.println("engine: float");
+#endif
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+  floatToFixedCount = 0;
+  fixedToFloatCount = 0;
+#endif
+  float update = measure(positionUpdate);
+  float movement = measure(movementCalls);
+  report("update", update);
+  report("RobusMovement", movement);
+  report("odometry and follower", update - movement);
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+  Serial.print("float to Q16.16 per tick: ");
+  Serial.println((float) floatToFixedCount / BENCHMARK_ITERATION);
+  Serial.print("Q16.16 to float per tick: ");
+  Serial.println((float) fixedToFloatCount / BENCHMARK_ITERATION);
+#endif
+  RobusPosition::stopFollowingTarget();
+
+  // Both include the conversion of the inputs, only the difference between them matters.
+  report("float division", measure(floatDivision));
+  report("Q16.16 division", measure(fixedDivision));
+}
+
+void loop() {
+}
@@ -0,0 +1,81 @@
+/*
+Time the LS7366 encoder reads before and after the SPI transaction rework.
+
+"legacy" repeats the old LS7366Counter::read(): digitalWrite() on the slave select and four bytes
+at the 4 MHz default SPI clock. The others call the current LibRobUS functions, which use an
+explicit LS7366_SPI_CLOCK (4 MHz by default, the LS7366R limit), direct port access and
+LS7366_COUNTER_BYTES bytes. Each byte takes 2 us on the wire at 4 MHz, build with
+-D LS7366_SPI_CLOCK=8000000 to time the previous, out-of-spec, 8 MHz default.
+Build once more with -D LS7366_COUNTER_BYTES=2 to time the 2-byte mode, meant for ENCODER_ReadDelta().
+
+Each read runs BENCHMARK_ITERATION times, the result is printed in microseconds per call.
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+#include <SPI.h>
+
+#define BENCHMARK_ITERATION 1000
+#define LEGACY_SLAVE_PIN 34 // Right counter
+
+volatile int32_t sink;
+
+int32_t legacyRead() {
+  uint32_t count[4];
+  int32_t count_value = 0;
+  digitalWrite(LEGACY_SLAVE_PIN, LOW);
+  SPI.transfer(0x60);
+  for (uint8_t i = 0; i < 4; i++) {
+    count[i] = SPI.transfer(0x00);
+  }
+  digitalWrite(LEGACY_SLAVE_PIN, HIGH);
+  for (uint8_t i = 0; i < 4; i++) {
+    count_value = (count_value << 8) + count[i];
+  }
+  return -count_value;
+}
+
+void report(const char *name, unsigned long elapsed) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print((float) elapsed / BENCHMARK_ITERATION);
+  Serial.println(" us per call");
+}
+
+void setup() {
+  BoardInit();
+
+  // Settings the old driver ran with, whatever SPI.begin() left
+  SPI.beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+  unsigned long start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = legacyRead();
+  }
+  report("legacy read", micros() - start);
+  SPI.endTransaction();
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = ENCODER_Read(RIGHT);
+  }
+  report("ENCODER_Read", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = ENCODER_ReadDelta(RIGHT);
+  }
+  report("ENCODER_ReadDelta", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < BENCHMARK_ITERATION; i++) {
+    sink = ENCODER_ReadBoth().right;
+  }
+  report("ENCODER_ReadBoth", micros() - start);
+
+  Serial.print("LS7366_SPI_CLOCK ");
+  Serial.print(LS7366_SPI_CLOCK);
+  Serial.print(", LS7366_COUNTER_BYTES ");
+  Serial.println(LS7366_COUNTER_BYTES);
+}
+
+void loop() {
+}
@@ -0,0 +1,51 @@
+/*
+Find where the loop time goes with the LibRobUS profiler.
+
+Build with -D LIBROBUS_PROFILER (build_flags in platformio.ini) so LibRobUS and RobusPosition
+time their hot functions: RobusPosition::update(), ENCODER_Read(), ENCODER_ReadBoth(),
+SOFT_TIMER_Update(), SONAR_GetRange() and DISPLAY_Printf(). Without it the sections compile to nothing.
+
+Type 'p' on Serial to print the table, 'r' to clear it. Each line reads
+"name calls min max total share": times in microseconds, share of the window in percent.
+Calls nested in another section count in both, ENCODER_ReadBoth() is part of the position update.
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+#include <RobusPosition.h>
+
+void showPosition() {
+  DISPLAY_Clear();
+  DISPLAY_Printf(String(RobusPosition::getPosition().x, 3));
+}
+
+void setup() {
+  BoardInit();
+  DisplayInit();
+  RobusPosition::setOdometrySource(RobusPosition::ENCODER_TICKS);
+
+  SOFT_TIMER_SetCallback(0, showPosition);
+  SOFT_TIMER_SetDelay(0, 500);
+  SOFT_TIMER_Enable(0);
+  PROFILER_Reset();
+}
+
+void loop() {
+  RobusPosition::update();
+  SONAR_GetRange(0);
+  SOFT_TIMER_Update();
+
+  {
+    // Any block of the sketch can be measured in a user section.
+    PROFILER_SCOPE(PROFILER_USER_0);
+    delayMicroseconds(100);
+  }
+
+  switch (Serial.read()) {
+    case 'p':
+      PROFILER_Dump();
+      break;
+    case 'r':
+      PROFILER_Reset();
+      break;
+  }
+}
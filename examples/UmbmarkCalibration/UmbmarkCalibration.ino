@@ -0,0 +1,75 @@
+/*
+Calibrate the encoder odometry with UMBmark squares and save the result to EEPROM.
+
+Mark the start spot on the floor, put the robot on it facing the first leg and press a bumper:
+the front bumper drives a counterclockwise square, the rear bumper a clockwise one. When the
+robot stops, type the offset of its real position from the mark in meters, "x y", with X along
+the first leg and Y to its left. Alternate the directions for a few runs, then press the left
+bumper to compute, apply and save the calibration. Put the robot back on the mark before each run.
+
+The calibration is saved with the other parameters, sketches restore it with
+RobusPosition::loadParameters() in setup().
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+#include <RobusPosition.h>
+
+#define SQUARE_SIDE 1.0
+
+bool waitingMeasure = false;
+bool lastClockwise = false;
+
+void setup() {
+  BoardInit();
+  Serial.begin(9600);
+  RobusPosition::setOdometrySource(RobusPosition::ENCODER_TICKS);
+  RobusPosition::loadParameters();
+  RobusPosition::setCalibrationSquare(SQUARE_SIDE);
+  Serial.println("Front bumper: counterclockwise square, rear bumper: clockwise square, left bumper: apply.");
+}
+
+void printCalibration() {
+  RobusPosition::WheelCalibration calibration = RobusPosition::getWheelCalibration();
+  Serial.print("left ");
+  Serial.print(calibration.leftScale, 5);
+  Serial.print(", right ");
+  Serial.print(calibration.rightScale, 5);
+  Serial.print(", track ");
+  Serial.println(calibration.trackScale, 5);
+}
+
+void loop() {
+  RobusPosition::update();
+
+  if (RobusPosition::isCalibrationRunning()) {
+    return;
+  }
+
+  if (waitingMeasure) {
+    if (Serial.available()) {
+      float x = Serial.parseFloat();
+      float y = Serial.parseFloat();
+      RobusPosition::addCalibrationRun(lastClockwise, x, y);
+      waitingMeasure = false;
+      Serial.println("Run added.");
+    }
+    return;
+  }
+
+  if (ROBUS_IsBumper(FRONT) || ROBUS_IsBumper(REAR)) {
+    lastClockwise = ROBUS_IsBumper(REAR);
+    delay(1000);
+    if (RobusPosition::startCalibrationRun(lastClockwise)) {
+      waitingMeasure = true;
+      Serial.println("Driving, then type the end error \"x y\".");
+    }
+  } else if (ROBUS_IsBumper(LEFT)) {
+    if (RobusPosition::applyCalibration()) {
+      Serial.print("Saved calibration: ");
+      printCalibration();
+    } else {
+      Serial.println("Needs at least one run in each direction.");
+    }
+    delay(500);
+  }
+}
@@ -0,0 +1,53 @@
+/*
+Estimate the wheel speeds at 1 kHz with the M/T method and the alpha-beta filter.
+
+The encoder sampler latches both LS7366 counters every millisecond, each sample goes through a
+VelocityEstimator per wheel. Compare the raw count-per-millisecond speed with the estimate at low
+speed: the first jumps between 0 and 1000 ticks/s, the second follows the real speed.
+*/
+#include <Arduino.h>
+#include <LibRobus.h>
+
+#define SAMPLE_FREQUENCY 1000
+#define FILTER_ALPHA 0.3
+#define PRINT_PERIOD 100 // ms
+
+VelocityEstimator leftWheel;
+VelocityEstimator rightWheel;
+int32_t lastLeft = 0;
+unsigned long lastPrint = 0;
+
+void setup() {
+  BoardInit();
+  leftWheel.setFilter(FILTER_ALPHA, FILTER_ALPHA * FILTER_ALPHA / (2 - FILTER_ALPHA));
+  rightWheel.setFilter(FILTER_ALPHA, FILTER_ALPHA * FILTER_ALPHA / (2 - FILTER_ALPHA));
+
+  EncoderCounts counts = ENCODER_ReadBoth();
+  leftWheel.reset(counts.left, counts.timestamp);
+  rightWheel.reset(counts.right, counts.timestamp);
+  lastLeft = counts.left;
+
+  MOTOR_SetSpeed(LEFT, 0.05);
+  MOTOR_SetSpeed(RIGHT, 0.05);
+  ENCODER_SamplerStart(SAMPLE_FREQUENCY);
+}
+
+void loop() {
+  EncoderCounts sample;
+  int32_t countSpeed = 0;
+  while (ENCODER_SamplerRead(sample)) {
+    leftWheel.update(sample.left, sample.timestamp);
+    rightWheel.update(sample.right, sample.timestamp);
+    countSpeed = LS7366Counter::delta(sample.left, lastLeft) * SAMPLE_FREQUENCY;
+    lastLeft = sample.left;
+  }
+
+  if (millis() - lastPrint >= PRINT_PERIOD) {
+    lastPrint = millis();
+    Serial.print(countSpeed);
+    Serial.print(' ');
+    Serial.print(leftWheel.getVelocity());
+    Serial.print(' ');
+    Serial.println(rightWheel.getVelocity());
+  }
+}
@@ -0,0 +1,70 @@
+/*
+Minimal Arduino API for the host-native build of RobusPosition.
+Time comes from the simulated clock of Simulation.h instead of the hardware timers.
+*/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+#define pgm_read_dword(address) (*(const uint32_t *) (address))
+#define pgm_read_float(address) (*(const float *) (address))
+
+#define noInterrupts()
+#define interrupts()
+
+#define F_CPU 16000000UL
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * @brief Serial port printing to the standard output.
+ */
+class HostSerial
+{
+  public:
+    void begin(unsigned long) {}
+    void flush() { fflush(stdout); }
+    int available() { return 0; }
+    int read() { return -1; }
+
+    size_t write(uint8_t value) { return fwrite(&value, 1, 1, stdout); }
+    size_t write(const uint8_t *buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+
+    void print(const char *value) { fputs(value, stdout); }
+    void print(char value) { putchar(value); }
+    void print(int value) { printf("%d", value); }
+    void print(unsigned int value) { printf("%u", value); }
+    void print(long value) { printf("%ld", value); }
+    void print(unsigned long value) { printf("%lu", value); }
+    void print(double value, int digits = 2) { printf("%.*f", digits, value); }
+
+    void println() { putchar('\n'); }
+    template<typename T> void println(T value) { print(value); println(); }
+    void println(double value, int digits) { print(value, digits); println(); }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
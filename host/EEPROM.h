@@ -0,0 +1,41 @@
+/*
+Simulated EEPROM for the host-native build, with the size of the ATmega2560 EEPROM.
+The content lasts for the run of the program and starts erased.
+*/
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+#define E2END 0xFFF
+
+/**
+ * @brief EEPROM with the interface of the Arduino EEPROM library.
+ */
+class HostEEPROM
+{
+  public:
+    HostEEPROM() { memset(data_, 0xFF, sizeof(data_)); }
+
+    uint8_t read(int address) const { return data_[address]; }
+    void write(int address, uint8_t value) { data_[address] = value; }
+    void update(int address, uint8_t value) { data_[address] = value; }
+    uint16_t length() const { return sizeof(data_); }
+
+    template<typename T> T &get(int address, T &value) const {
+        memcpy(&value, &data_[address], sizeof(T));
+        return value;
+    }
+
+    template<typename T> const T &put(int address, const T &value) {
+        memcpy(&data_[address], &value, sizeof(T));
+        return value;
+    }
+
+  private:
+    uint8_t data_[E2END + 1];
+};
+
+extern HostEEPROM EEPROM;
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,36 @@
+/*
+Simulated LibRobUS for the host-native build.
+Only the functions used by RobusPosition are provided, backed by Simulation.h.
+*/
+#ifndef HOST_LIBROBUS_H
+#define HOST_LIBROBUS_H
+
+#include <Arduino.h>
+
+#define LEFT 0
+#define RIGHT 1
+#define FRONT 2
+#define REAR 3
+
+#ifndef LS7366_COUNTER_BYTES
+#define LS7366_COUNTER_BYTES 4 // Width of the simulated counters, like LS7366Counter.h
+#endif
+
+struct EncoderCounts
+{
+    int32_t left;
+    int32_t right;
+    uint32_t timestamp;
+};
+
+int32_t ENCODER_Read(uint8_t id);
+void ENCODER_Reset(uint8_t id);
+EncoderCounts ENCODER_ReadBoth();
+
+float SONAR_GetRange(uint8_t id);
+uint16_t ROBUS_ReadIR(uint8_t id);
+
+// The profiler is not simulated.
+#define PROFILER_SCOPE(section)
+
+#endif // HOST_LIBROBUS_H
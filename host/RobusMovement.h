@@ -0,0 +1,21 @@
+/*
+Simulated RobusMovement for the host-native build.
+Commands go to the differential-drive plant of Simulation.h and measures come back from it.
+*/
+#ifndef HOST_ROBUS_MOVEMENT_H
+#define HOST_ROBUS_MOVEMENT_H
+
+namespace RobusMovement
+{
+    void update();
+    void stop();
+
+    void setVelocity(float velocity);
+    void setAngularVelocity(float angularVelocity);
+
+    float getVelocity();
+    float getAngularVelocity();
+    float computeOrientation();
+}
+
+#endif // HOST_ROBUS_MOVEMENT_H
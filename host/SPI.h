@@ -0,0 +1,10 @@
+/*
+Empty SPI header for the host-native build, LS7366Counter.h only needs it to declare its class.
+The host build uses the static helpers of LS7366Counter, never the SPI bus.
+*/
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#endif // HOST_SPI_H
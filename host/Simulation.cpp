@@ -0,0 +1,238 @@
+#include "Simulation.h"
+#include <RobusMovement.h>
+#include <LibRobus.h>
+#include <EEPROM.h>
+#include <stdlib.h>
+
+HostSerial Serial;
+HostEEPROM EEPROM;
+
+namespace Simulation
+{
+    DifferentialDrive::DifferentialDrive() {
+        timeConstant = 0.05;
+        trackWidth = 0.187;
+        distancePerTick = 0.0000748;
+        leftScale = 1;
+        rightScale = 1;
+        trackScale = 1;
+        commandLeft_ = 0;
+        commandRight_ = 0;
+        for (uint8_t id = 0; id < 2; id++) {
+            wheelSpeed_[id] = 0;
+            wheelDistance_[id] = 0;
+        }
+        setPose(0, 0, 0);
+    }
+
+    void DifferentialDrive::setCommand(float velocity, float angularVelocity) {
+        commandLeft_ = velocity - angularVelocity * trackWidth / 2;
+        commandRight_ = velocity + angularVelocity * trackWidth / 2;
+    }
+
+    void DifferentialDrive::step(double dt) {
+        // Exact response of the first-order lag for a constant command.
+        double response = timeConstant > 0 ? 1 - exp(-dt / timeConstant) : 1;
+        wheelSpeed_[LEFT] += (commandLeft_ - wheelSpeed_[LEFT]) * response;
+        wheelSpeed_[RIGHT] += (commandRight_ - wheelSpeed_[RIGHT]) * response;
+
+        double left = wheelSpeed_[LEFT] * dt;
+        double right = wheelSpeed_[RIGHT] * dt;
+        wheelDistance_[LEFT] += left;
+        wheelDistance_[RIGHT] += right;
+        measuredOrientation_ += (right - left) / trackWidth;
+
+        double groundLeft = left * leftScale;
+        double groundRight = right * rightScale;
+        double distance = (groundLeft + groundRight) / 2;
+        double rotation = (groundRight - groundLeft) / (trackWidth * trackScale);
+
+        // Chord of the arc travelled during the step.
+        double chord = fabs(rotation) > 1e-9 ? distance * sin(rotation / 2) / (rotation / 2) : distance;
+        x_ += chord * cos(orientation_ + rotation / 2);
+        y_ += chord * sin(orientation_ + rotation / 2);
+        orientation_ += rotation;
+    }
+
+    void DifferentialDrive::setPose(double x, double y, double orientation) {
+        x_ = x;
+        y_ = y;
+        orientation_ = orientation;
+        measuredOrientation_ = orientation;
+    }
+
+    float DifferentialDrive::getVelocity() const {
+        return (wheelSpeed_[LEFT] + wheelSpeed_[RIGHT]) / 2;
+    }
+
+    float DifferentialDrive::getAngularVelocity() const {
+        return (wheelSpeed_[RIGHT] - wheelSpeed_[LEFT]) / trackWidth;
+    }
+
+    int32_t DifferentialDrive::readEncoder(uint8_t id) const {
+        // Wraps at the width of the counter and sign-extended, like LS7366Counter::read().
+        const uint8_t shift = 32 - 8 * LS7366_COUNTER_BYTES;
+        return (int32_t) ((uint32_t) (int64_t) floor(wheelDistance_[id] / distancePerTick) << shift) >> shift;
+    }
+
+    void DifferentialDrive::resetEncoder(uint8_t id) {
+        wheelDistance_[id] = 0;
+    }
+
+    namespace {
+        struct Segment {
+            double x1, y1, x2, y2;
+        };
+
+        struct Mount {
+            double x, y, angle;
+        };
+
+        DifferentialDrive plant;
+        unsigned long time = 0;
+        Segment walls[16];
+        uint8_t wallCount = 0;
+        Mount sonars[2] = {{0, 0, 0}, {0, 0, 0}};
+    }
+
+    DifferentialDrive &robot() {
+        return plant;
+    }
+
+    unsigned long clock() {
+        return time;
+    }
+
+    void advance(unsigned long us) {
+        time += us;
+        plant.step(us / 1000000.0);
+    }
+
+    void addWall(double x1, double y1, double x2, double y2) {
+        if (wallCount < sizeof(walls) / sizeof(walls[0])) {
+            Segment wall = {x1, y1, x2, y2};
+            walls[wallCount++] = wall;
+        }
+    }
+
+    void setSonar(uint8_t id, double x, double y, double angle) {
+        Mount mount = {x, y, angle};
+        sonars[id] = mount;
+    }
+
+    double sonarRange(uint8_t id) {
+        const Mount &mount = sonars[id];
+        double orientation = plant.getTrueOrientation();
+        double originX = plant.getX() + cos(orientation) * mount.x - sin(orientation) * mount.y;
+        double originY = plant.getY() + sin(orientation) * mount.x + cos(orientation) * mount.y;
+        double beamX = cos(orientation + mount.angle);
+        double beamY = sin(orientation + mount.angle);
+
+        double closest = -1;
+        for (uint8_t i = 0; i < wallCount; i++) {
+            const Segment &wall = walls[i];
+            double wallX = wall.x2 - wall.x1;
+            double wallY = wall.y2 - wall.y1;
+            double denominator = beamX * wallY - beamY * wallX;
+            if (fabs(denominator) < 1e-12) {
+                continue;
+            }
+            // Solve origin + range * beam = start + along * wall.
+            double range = ((wall.x1 - originX) * wallY - (wall.y1 - originY) * wallX) / denominator;
+            double along = ((wall.x1 - originX) * beamY - (wall.y1 - originY) * beamX) / denominator;
+            if (range > 0 && along >= 0 && along <= 1 && (closest < 0 || range < closest)) {
+                closest = range;
+            }
+        }
+        return closest;
+    }
+
+    void reset() {
+        time = 0;
+        plant = DifferentialDrive();
+        wallCount = 0;
+    }
+}
+
+unsigned long micros() {
+    return Simulation::clock();
+}
+
+unsigned long millis() {
+    return Simulation::clock() / 1000;
+}
+
+void delay(unsigned long ms) {
+    Simulation::advance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    Simulation::advance(us);
+}
+
+int32_t ENCODER_Read(uint8_t id) {
+    return Simulation::robot().readEncoder(id);
+}
+
+void ENCODER_Reset(uint8_t id) {
+    Simulation::robot().resetEncoder(id);
+}
+
+EncoderCounts ENCODER_ReadBoth() {
+    // The simulated counters stand still between steps, like two latched at once.
+    EncoderCounts counts;
+    counts.left = Simulation::robot().readEncoder(LEFT);
+    counts.right = Simulation::robot().readEncoder(RIGHT);
+    counts.timestamp = Simulation::clock();
+    return counts;
+}
+
+float SONAR_GetRange(uint8_t id) {
+    // Centimeters like the SRF04 driver, with a uniform +-1 cm noise.
+    double range = Simulation::sonarRange(id);
+    if (range < 0) {
+        return 0;
+    }
+    return range * 100 + (rand() % 2001 - 1000) / 1000.0;
+}
+
+uint16_t ROBUS_ReadIR(uint8_t) {
+    return 0;
+}
+
+namespace RobusMovement
+{
+    namespace {
+        float velocity = 0;
+        float angularVelocity = 0;
+    }
+
+    void update() {
+        Simulation::robot().setCommand(velocity, angularVelocity);
+    }
+
+    void stop() {
+        velocity = 0;
+        angularVelocity = 0;
+    }
+
+    void setVelocity(float value) {
+        velocity = value;
+    }
+
+    void setAngularVelocity(float value) {
+        angularVelocity = value;
+    }
+
+    float getVelocity() {
+        return Simulation::robot().getVelocity();
+    }
+
+    float getAngularVelocity() {
+        return Simulation::robot().getAngularVelocity();
+    }
+
+    float computeOrientation() {
+        return Simulation::robot().getOrientation();
+    }
+}
@@ -0,0 +1,124 @@
+/*
+Deterministic simulation of the Robus robot for the host-native build.
+The clock only moves when advance() is called, so scenarios run as fast as the host allows.
+*/
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <Arduino.h>
+
+namespace Simulation
+{
+    /**
+     * @brief Differential-drive plant with speed-controlled wheels.
+     *
+     * Each wheel reaches its commanded speed with a first-order lag, as seen by its encoder.
+     * The ground speed of a wheel is its encoder speed times its scale, so wheel diameter and
+     * track width errors can be simulated.
+     */
+    class DifferentialDrive
+    {
+      public:
+        DifferentialDrive();
+
+        /**
+         * @brief Set the commanded velocity and angular velocity.
+         * @param velocity The linear velocity.
+         * @param angularVelocity The angular velocity in radians per second.
+         */
+        void setCommand(float velocity, float angularVelocity);
+
+        /**
+         * @brief Move the plant forward in time.
+         * @param dt The time step in seconds.
+         */
+        void step(double dt);
+
+        /**
+         * @brief Place the robot, both its true and measured poses.
+         */
+        void setPose(double x, double y, double orientation);
+
+        /** Velocity measured by the encoders. */
+        float getVelocity() const;
+        /** Angular velocity measured by the encoders, in radians per second. */
+        float getAngularVelocity() const;
+        /** Orientation integrated from the encoders, in radians. */
+        float getOrientation() const { return measuredOrientation_; }
+
+        /** True pose of the robot. */
+        double getX() const { return x_; }
+        double getY() const { return y_; }
+        double getTrueOrientation() const { return orientation_; }
+
+        /**
+         * @brief Read the tick count of a wheel encoder.
+         * @param id LEFT(0) or RIGHT(1).
+         * @return The tick count, wrapping at LS7366_COUNTER_BYTES like the hardware counter.
+         */
+        int32_t readEncoder(uint8_t id) const;
+        void resetEncoder(uint8_t id);
+
+        double timeConstant;    /**< Wheel speed response time constant, in seconds. */
+        double trackWidth;      /**< Nominal distance between the wheels. */
+        double distancePerTick; /**< Nominal distance travelled by a wheel per encoder tick. */
+        double leftScale;       /**< True over nominal left wheel diameter. */
+        double rightScale;      /**< True over nominal right wheel diameter. */
+        double trackScale;      /**< True over nominal track width. */
+
+      private:
+        float commandLeft_;
+        float commandRight_;
+        double wheelSpeed_[2];    // Encoder speed of each wheel
+        double wheelDistance_[2]; // Encoder distance of each wheel since reset
+        double x_;
+        double y_;
+        double orientation_;
+        double measuredOrientation_;
+    };
+
+    /**
+     * @brief Get the plant behind the simulated RobusMovement and LibRobUS.
+     */
+    DifferentialDrive &robot();
+
+    /**
+     * @brief Get the simulated time.
+     * @return The time in microseconds.
+     */
+    unsigned long clock();
+
+    /**
+     * @brief Move the simulated time and the plant forward.
+     * @param us The time step in microseconds.
+     */
+    void advance(unsigned long us);
+
+    /**
+     * @brief Add a wall the simulated sonars can see.
+     */
+    void addWall(double x1, double y1, double x2, double y2);
+
+    /**
+     * @brief Mount a simulated sonar on the robot.
+     * @param id The sonar, 0 or 1.
+     * @param x Forward offset from the center of the wheels.
+     * @param y Leftward offset from the center of the wheels.
+     * @param angle Direction of the beam from the robot heading, in radians.
+     */
+    void setSonar(uint8_t id, double x, double y, double angle);
+
+    /**
+     * @brief Get the true distance from a sonar to the closest wall along its beam.
+     * @param id The sonar, 0 or 1.
+     * @return The distance, or a negative value if the beam hits no wall.
+     */
+    double sonarRange(uint8_t id);
+
+    /**
+     * @brief Put the clock back to zero, the plant back to its default state and remove the walls.
+     */
+    void reset();
+}
+
+#endif // SIMULATION_H
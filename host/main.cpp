@@ -0,0 +1,1171 @@
+/*
+Host-native scenarios for RobusPosition.
+
+Usage:
+  robus_position_sim [square|waypoints|fixedrate|history|filter|map|plan|calibrate|persist|record|fastmath|curve|integrators|profile|velocity|benchmark|sweep|search] [ticks] [rate]
+  robus_position_sim replay <file>
+
+square     Follow the corners of a 1 m square, then report the odometry error.
+waypoints  Same square as a waypoint path, blending through the corners.
+fixedrate  Waypoint path driven by the fixed-rate mode, with the timer interrupt arriving late at random.
+history    Query the pose history between its records, across the ring wraparound and the micros() overflow.
+filter     Three laps with mismatched wheels in a walled arena, odometry alone then corrected by the sonars.
+map        One lap of the arena filling the occupancy grid from the sonars, then print the grid.
+plan       Plan across the arena through an unknown wall, replanning as the sonars and the bumper find it.
+calibrate  UMBmark squares with mismatched wheels and track width, before and after the calibration.
+persist    Save and restore the parameters and the pose through the EEPROM store, with a torn pose write.
+record     Record the waypoint square and write the binary dump to the standard output.
+replay     Replay a dump from record or dumpRecording() and check the poses are the same bit for bit.
+fastmath   Check the FastMath kernels against libm over [ticks] samples and compare their speed.
+curve      Check the speed curve table against pow(cos(error), tightness) in float and Q16.16.
+integrators  Integrate one lap of a tight circle with each integrator and compare with the closed form.
+profile    Drive a point mass to a stop through the motion profile and check the overshoot and the limits.
+velocity   Estimate the speed of a wheel latched at 1 kHz across the counter wrap and a reversal, with the RMS errors.
+benchmark  Run the follower in circles and report how many control ticks per second the host runs.
+sweep      Grid search of the follow velocity, angular velocity scale and curve tightness on all cores.
+search     Same as sweep over random configurations.
+*/
+#include <Arduino.h>
+#include <RobusPosition.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <FastMath.h>
+#include <EEPROM.h>
+#include <LS7366Counter/LS7366Counter.h>
+#include <VelocityEstimator/VelocityEstimator.h>
+#include "Simulation.h"
+
+#ifndef SWEEP_THREADS
+#define SWEEP_THREADS 0 // Threads of the sweep pool, 0 for one per core
+#endif
+
+namespace {
+    struct Scenario {
+        const char *name;
+        int (*run)(unsigned long ticks, unsigned long period);
+    };
+
+    double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void setup() {
+        Simulation::reset();
+        RobusPosition::setClock(Simulation::clock);
+        RobusPosition::setPosition(0, 0);
+        RobusPosition::setFollowVelocity(0.3);
+        RobusPosition::stopFollowingTarget();
+        RobusPosition::update();
+    }
+
+    int runSquare(unsigned long ticks, unsigned long period) {
+        const RobusPosition::Vector corners[] = {
+            RobusPosition::Vector(1, 0),
+            RobusPosition::Vector(1, 1),
+            RobusPosition::Vector(0, 1),
+            RobusPosition::Vector(0, 0)
+        };
+        const uint8_t cornerCount = sizeof(corners) / sizeof(corners[0]);
+
+        setup();
+        // Standing still, the updates leave the pose and its generation alone.
+        uint32_t generation = RobusPosition::getPoseGeneration();
+        for (int i = 0; i < 10; i++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+        }
+        bool still = RobusPosition::getPoseGeneration() == generation;
+
+        uint8_t corner = 0;
+        RobusPosition::setTarget(corners[corner]);
+        RobusPosition::startFollowingTarget();
+
+        unsigned long tick = 0;
+        for (; tick < ticks && corner < cornerCount; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+
+            RobusPosition::Vector position = RobusPosition::getPosition();
+            if (dist(position.x, position.y, corners[corner].x, corners[corner].y) < 0.02) {
+                corner++;
+                if (corner < cornerCount) {
+                    RobusPosition::setTarget(corners[corner]);
+                }
+            }
+        }
+
+        const Simulation::DifferentialDrive &robot = Simulation::robot();
+        RobusPosition::Vector position = RobusPosition::getPosition();
+        printf("corners reached: %u/%u in %.3f s\n", corner, cornerCount, tick * period / 1000000.0);
+        printf("estimated pose: %.4f %.4f %.4f\n", position.x, position.y, RobusPosition::getOrientation());
+        printf("true pose:      %.4f %.4f %.4f\n", robot.getX(), robot.getY(), robot.getTrueOrientation());
+        printf("pose generation: %s standing still, %lu after the square\n", still ? "kept" : "CHANGED",
+               (unsigned long) (RobusPosition::getPoseGeneration() - generation));
+        return corner == cornerCount && still && RobusPosition::getPoseGeneration() != generation ? 0 : 1;
+    }
+
+    int runWaypoints(unsigned long ticks, unsigned long period) {
+        setup();
+        RobusPosition::clearWaypoints();
+        RobusPosition::addWaypoint(1, 0);
+        RobusPosition::addWaypoint(1, 1);
+        RobusPosition::addWaypoint(0, 1);
+        RobusPosition::addWaypoint(0, 0);
+        RobusPosition::startFollowingTarget();
+
+        unsigned long tick = 0;
+        for (; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+        }
+
+        const Simulation::DifferentialDrive &robot = Simulation::robot();
+        RobusPosition::Vector position = RobusPosition::getPosition();
+        printf("waypoints reached: %u/4 in %.3f s\n", RobusPosition::getCompletedWaypoints(), tick * period / 1000000.0);
+        printf("estimated pose: %.4f %.4f %.4f\n", position.x, position.y, RobusPosition::getOrientation());
+        printf("true pose:      %.4f %.4f %.4f\n", robot.getX(), robot.getY(), robot.getTrueOrientation());
+        return RobusPosition::getWaypointCount() == 0 ? 0 : 1;
+    }
+
+    int runFixedRate(unsigned long ticks, unsigned long period) {
+        setup();
+        RobusPosition::clearWaypoints();
+        RobusPosition::addWaypoint(1, 0);
+        RobusPosition::addWaypoint(1, 1);
+        RobusPosition::addWaypoint(0, 1);
+        RobusPosition::addWaypoint(0, 0);
+        RobusPosition::startFixedRate(1000000 / period);
+        RobusPosition::startFollowingTarget();
+
+        srand(1);
+        unsigned long tick = 0;
+        unsigned long late = 0;
+        for (; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            // The compare match is scheduled from the previous one, so latency does not accumulate.
+            unsigned long latency = rand() % (period / 10 + 1);
+            Simulation::advance(period + latency - late);
+            late = latency;
+            RobusPosition::fixedRateInterrupt();
+            RobusPosition::update(); // Ignored in fixed-rate mode.
+        }
+        RobusPosition::stopFixedRate();
+
+        RobusPosition::LoopStatistics statistics = RobusPosition::getLoopStatistics();
+        const Simulation::DifferentialDrive &robot = Simulation::robot();
+        RobusPosition::Vector position = RobusPosition::getPosition();
+        printf("waypoints reached: %u/4 in %.3f s\n", RobusPosition::getCompletedWaypoints(), tick * period / 1000000.0);
+        printf("updates: %lu, overruns: %u, interval: %lu..%lu us, max jitter: %lu us\n",
+               (unsigned long) statistics.updates, statistics.overruns,
+               statistics.minInterval, statistics.maxInterval, statistics.maxJitter);
+        printf("estimated pose: %.4f %.4f %.4f\n", position.x, position.y, RobusPosition::getOrientation());
+        printf("true pose:      %.4f %.4f %.4f\n", robot.getX(), robot.getY(), robot.getTrueOrientation());
+        return RobusPosition::getWaypointCount() == 0 ? 0 : 1;
+    }
+
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+    // Pose of the history scenario, elapsed microseconds after its first record, turning spin radians per microsecond.
+    RobusPosition::Pose historyPose(unsigned long elapsed, double spin) {
+        double angle = fmod(elapsed * spin + 101 * PI, TWO_PI) - PI;
+        // Curved path, so interpolating between the wrong records shows.
+        return RobusPosition::Pose(elapsed * 0.3e-6, elapsed * 1e-5 * elapsed * 1e-5, angle);
+    }
+
+    /**
+     * @brief Fill a pose history over many laps of its ring and check getPoseAt() against the true poses.
+     * @param start Timestamp of the first record, close to the overflow to test the wrap of micros().
+     * @param records Number of poses recorded.
+     * @param spin Turn rate in radians per microsecond, about 1.2 rad between records wraps the orientation often.
+     * @return The number of failed checks.
+     */
+    unsigned checkPoseHistory(unsigned long start, unsigned long records, double spin) {
+        RobusPosition::PoseHistory history;
+        RobusPosition::Pose pose;
+        unsigned failures = history.getPoseAt(start, pose) ? 1 : 0;
+
+        std::vector<unsigned long> elapsed;
+        for (unsigned long i = 0; i < records; i++) {
+            // Irregular intervals, as update() sees them.
+            elapsed.push_back(i == 0 ? 0 : elapsed.back() + 1000 + i * 37 % 500);
+            history.record(start + elapsed.back(), historyPose(elapsed.back(), spin));
+        }
+        unsigned long newest = elapsed.back();
+        unsigned long oldest = elapsed[records - history.size()];
+
+        // Every 10 us over the whole history, on and between the records.
+        double error = 0;
+        size_t next = records - history.size();
+        for (unsigned long age = oldest; age <= newest; age += 10) {
+            if (!history.getPoseAt(start + age, pose)) {
+                failures++;
+                continue;
+            }
+            while (next + 1 < records && elapsed[next] <= age) {
+                next++;
+            }
+            // Straight between the two records around it, the heading turns at a constant rate.
+            RobusPosition::Pose before = historyPose(elapsed[next - 1], spin);
+            RobusPosition::Pose after = historyPose(elapsed[next], spin);
+            double t = (double) (age - elapsed[next - 1]) / (elapsed[next] - elapsed[next - 1]);
+            RobusPosition::Pose expected = historyPose(age, spin);
+            expected.x = before.x + (after.x - before.x) * t;
+            expected.y = before.y + (after.y - before.y) * t;
+            double rotation = fabs(pose.orientation - expected.orientation);
+            error = fmax(error, fmax(hypot(pose.x - expected.x, pose.y - expected.y), fmin(rotation, TWO_PI - rotation)));
+        }
+        failures += error < 1e-5 ? 0 : 1;
+
+        // Past the newest record it is the newest pose, before the oldest there is no pose.
+        failures += history.getPoseAt(start + newest + 5000, pose) && pose.x == historyPose(newest, spin).x ? 0 : 1;
+        failures += history.getPoseAt(start + oldest - 1, pose) ? 1 : 0;
+        failures += history.getPoseAt(start + oldest - 1000000, pose) ? 1 : 0;
+
+        uint8_t size = history.size();
+        history.clear();
+        failures += history.getPoseAt(start + newest, pose) ? 1 : 0;
+        printf("%lu records from %lu, %u in the ring: largest error %.3g, %u failed checks\n",
+               records, start, size, error, failures);
+        return failures;
+    }
+
+    int runHistory(unsigned long, unsigned long) {
+        unsigned failures = 0;
+        // Less than a ring, exactly a ring, several laps of the ring.
+        failures += checkPoseHistory(1000, POSE_HISTORY_SIZE / 2, 1e-3);
+        failures += checkPoseHistory(1000, POSE_HISTORY_SIZE, -1e-3);
+        failures += checkPoseHistory(1000, POSE_HISTORY_SIZE * 3 + 5, 1e-3);
+        // micros() overflows in the middle of the history.
+        failures += checkPoseHistory((unsigned long) -1 - POSE_HISTORY_SIZE * 600, POSE_HISTORY_SIZE * 3 + 5, -1e-3);
+        return failures == 0 ? 0 : 1;
+    }
+#endif
+
+    /**
+     * @brief Build a 2 m arena around the square, a sonar looking forward and one looking left.
+     */
+    void setupArena() {
+        Simulation::addWall(-0.5, -0.5, 1.5, -0.5);
+        Simulation::addWall(1.5, -0.5, 1.5, 1.5);
+        Simulation::addWall(1.5, 1.5, -0.5, 1.5);
+        Simulation::addWall(-0.5, 1.5, -0.5, -0.5);
+        Simulation::setSonar(0, 0.1, 0, 0);
+        Simulation::setSonar(1, 0, 0.1, HALF_PI);
+
+        RobusPosition::clearWalls();
+        RobusPosition::addWall(-0.5, -0.5, 1.5, -0.5);
+        RobusPosition::addWall(1.5, -0.5, 1.5, 1.5);
+        RobusPosition::addWall(1.5, 1.5, -0.5, 1.5);
+        RobusPosition::addWall(-0.5, 1.5, -0.5, -0.5);
+        RobusPosition::setSonarMount(0, RobusPosition::RangeSensor(0.1, 0, 0, 0.0001, 0.03, 3));
+        RobusPosition::setSonarMount(1, RobusPosition::RangeSensor(0, 0.1, HALF_PI, 0.0001, 0.03, 3));
+    }
+
+    /**
+     * @brief Drive three laps of the waypoint square and return the final position error.
+     */
+    double driveLaps(unsigned long ticks, unsigned long period, bool filtered) {
+        setup();
+        Simulation::DifferentialDrive &robot = Simulation::robot();
+        robot.leftScale = 1.01;
+        robot.rightScale = 0.99;
+        setupArena();
+        RobusPosition::resetPoseFilter(0, 0);
+        RobusPosition::setPoseFilterEnabled(filtered);
+
+        RobusPosition::clearWaypoints();
+        for (uint8_t lap = 0; lap < 3; lap++) {
+            RobusPosition::addWaypoint(1, 0);
+            RobusPosition::addWaypoint(1, 1);
+            RobusPosition::addWaypoint(0, 1);
+            RobusPosition::addWaypoint(0, 0);
+        }
+        RobusPosition::startFollowingTarget();
+
+        srand(1);
+        uint16_t accepted = 0;
+        unsigned long tick = 0;
+        for (; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+            if (tick % 5 == 0) {
+                accepted += RobusPosition::correctWithSonar(tick / 5 % 2);
+            }
+        }
+        RobusPosition::setPoseFilterEnabled(false);
+
+        RobusPosition::Vector position = RobusPosition::getPosition();
+        double error = hypot(position.x - robot.getX(), position.y - robot.getY());
+        printf("%-9s %u/12 waypoints in %.3f s, %u corrections, position error %.4f\n",
+               filtered ? "filtered:" : "odometry:", RobusPosition::getCompletedWaypoints(),
+               tick * period / 1000000.0, accepted, error);
+        if (filtered) {
+            RobusPosition::Matrix<3, 3> covariance = RobusPosition::getPoseCovariance();
+            printf("standard deviation: x %.4f y %.4f orientation %.4f\n",
+                   sqrt(covariance(0, 0)), sqrt(covariance(1, 1)), sqrt(covariance(2, 2)));
+        }
+        return error;
+    }
+
+    int runFilter(unsigned long ticks, unsigned long period) {
+        double odometryError = driveLaps(ticks, period, false);
+        double filteredError = driveLaps(ticks, period, true);
+        return filteredError < odometryError ? 0 : 1;
+    }
+
+    /**
+     * @brief Print the worst error of a kernel and whether it is within its documented bound.
+     */
+    bool reportError(const char *name, double error, double bound) {
+        bool passed = error <= bound;
+        printf("%-9s max error %.3g (bound %.3g) %s\n", name, error, bound, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    volatile float sink;
+
+    template<typename Kernel>
+    double timeKernel(Kernel kernel, unsigned long samples) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        float sum = 0;
+        for (unsigned long i = 0; i < samples; i++) {
+            sum += kernel(i * 0.001f - 50, i * 0.0007f - 20);
+        }
+        sink = sum;
+        return elapsedSeconds(start) * 1e9 / samples;
+    }
+
+    float libmSin(float a, float) { return sin(a); }
+    float fastSin(float a, float) { return FastMath::fastSin(a); }
+    float libmAtan2(float y, float x) { return atan2(y, x); }
+    float fastAtan2(float y, float x) { return FastMath::fastAtan2(y, x); }
+    float libmHypot(float x, float y) { return sqrt(x * x + y * y); }
+    float fastHypot(float x, float y) { return FastMath::fastHypot(x, y); }
+
+    int runFastMath(unsigned long ticks, unsigned long) {
+        double sinError = 0, cosError = 0, atan2Error = 0, hypotError = 0;
+        for (unsigned long i = 0; i <= ticks; i++) {
+            // Angles over [-1000, 1000] rad, vectors around the whole circle with lengths over six decades.
+            double angle = -1000 + 2000.0 * i / ticks;
+            sinError = fmax(sinError, fabs(FastMath::fastSin(angle) - sin((float) angle)));
+            cosError = fmax(cosError, fabs(FastMath::fastCos(angle) - cos((float) angle)));
+
+            double direction = TWO_PI * i / ticks;
+            double length = pow(10, -3 + 6.0 * (i % 1000) / 1000);
+            float x = length * cos(direction);
+            float y = length * sin(direction);
+            double error = fabs(FastMath::fastAtan2(y, x) - atan2((double) y, (double) x));
+            atan2Error = fmax(atan2Error, fmin(error, TWO_PI - error));
+            hypotError = fmax(hypotError, fabs(FastMath::fastHypot(x, y) / hypot((double) x, (double) y) - 1));
+        }
+
+        bool passed = reportError("sin", sinError, FAST_MATH_SIN_ERROR);
+        passed &= reportError("cos", cosError, FAST_MATH_SIN_ERROR);
+        passed &= reportError("atan2", atan2Error, FAST_MATH_ATAN2_ERROR);
+        passed &= reportError("hypot", hypotError, FAST_MATH_HYPOT_ERROR);
+
+        // Host timings only compare the kernels, examples/FastMathBenchmark gives the AVR cycles.
+        printf("sin:   libm %.1f ns, fast %.1f ns\n", timeKernel(libmSin, ticks), timeKernel(fastSin, ticks));
+        printf("atan2: libm %.1f ns, fast %.1f ns\n", timeKernel(libmAtan2, ticks), timeKernel(fastAtan2, ticks));
+        printf("hypot: libm %.1f ns, fast %.1f ns\n", timeKernel(libmHypot, ticks), timeKernel(fastHypot, ticks));
+        return passed ? 0 : 1;
+    }
+
+    int runCurve(unsigned long ticks, unsigned long) {
+        // Integer and fractional exponents, with a table spanning up to PI / 2 or cut short.
+        const float tightnesses[] = {0, 1, 2.5, 4, 7.3, 20, 50};
+        bool passed = true;
+        for (size_t t = 0; t < sizeof(tightnesses) / sizeof(tightnesses[0]); t++) {
+            float tightness = tightnesses[t];
+            RobusPosition::SpeedCurve curve(tightness);
+            double floatError = 0, fixedError = 0;
+            for (unsigned long i = 0; i <= ticks; i++) {
+                double error = -PI + TWO_PI * i / ticks;
+                double expected = fabs(error) < HALF_PI ? pow(cos(error), tightness) : 0;
+                float factor = curve.evaluate((float) error);
+                float fixedFactor = curve.evaluate(FixedPoint::Fixed((float) error)).toFloat();
+                // A NaN fails the comparison and shows as an infinite error.
+                floatError = factor >= 0 && factor <= 1 ? fmax(floatError, fabs(factor - expected)) : INFINITY;
+                fixedError = fixedFactor >= 0 && fixedFactor <= 1 ? fmax(fixedError, fabs(fixedFactor - expected)) : INFINITY;
+            }
+            char name[24];
+            snprintf(name, sizeof(name), "k=%g", tightness);
+            passed &= reportError(name, floatError, 1e-3);
+            snprintf(name, sizeof(name), "k=%g Q16", tightness);
+            passed &= reportError(name, fixedError, 1e-3);
+        }
+        return passed ? 0 : 1;
+    }
+
+    /**
+     * @brief Integrate a lap of a circle of constant curvature and return the largest error from the closed form.
+     * @param steps Calls to integrate() per update, EULER sub-steps on top of INTEGRATION_ITERATION.
+     */
+    double integrateCircle(RobusPosition::Integrator method, uint8_t steps, unsigned long updates, double dt,
+                           double velocity, double angularVelocity) {
+        RobusPosition::PositionOdometry odometry;
+        odometry.setIntegrator(method);
+        float distance = velocity * dt / steps;
+        float rotation = angularVelocity * dt / steps;
+        // Compare with the circle of the displacements as rounded to PositionScalar, Q16.16 rounds 3 mm by up to 0.25 %.
+        double stepAngle = (float) RobusPosition::PositionScalar(rotation) * (double) steps;
+        double radius = (float) RobusPosition::PositionScalar(distance) / (double) (float) RobusPosition::PositionScalar(rotation);
+        double error = 0;
+        for (unsigned long update = 1; update <= updates; update++) {
+            for (uint8_t i = 0; i < steps; i++) {
+                // The heading is known exactly, only the integration of the position is measured.
+                float orientation = ((update - 1) * steps + i) * (double) rotation;
+                odometry.update(RobusPosition::PositionScalar(orientation), RobusPosition::PositionScalar(distance),
+                                RobusPosition::PositionScalar(rotation));
+            }
+            double angle = stepAngle * update;
+            error = fmax(error, hypot((float) odometry.getX() - radius * sin(angle), (float) odometry.getY() - radius * (1 - cos(angle))));
+        }
+        return error;
+    }
+
+    int runIntegrators(unsigned long ticks, unsigned long period) {
+        // Radius of 5 cm at 0.3 m/s, 6 rad/s: much tighter than the follower drives.
+        const double velocity = 0.3;
+        const double angularVelocity = 6;
+        double dt = period / 1000000.0;
+        unsigned long updates = std::min(ticks, (unsigned long) (TWO_PI / angularVelocity / dt + 0.5));
+        printf("%lu updates of %.3f rad on a %.0f mm radius\n", updates, angularVelocity * dt, velocity / angularVelocity * 1000);
+
+        double euler = 0;
+        for (uint8_t steps = 1; steps <= 16; steps *= 4) {
+            euler = integrateCircle(RobusPosition::EULER, steps, updates, dt, velocity, angularVelocity);
+            printf("EULER x%-3u max error %.4f mm\n", steps * INTEGRATION_ITERATION, euler * 1000);
+        }
+        double midpoint = integrateCircle(RobusPosition::MIDPOINT, 1, updates, dt, velocity, angularVelocity);
+        double rk4 = integrateCircle(RobusPosition::RK4, 1, updates, dt, velocity, angularVelocity);
+        double arc = integrateCircle(RobusPosition::ARC, 1, updates, dt, velocity, angularVelocity);
+        printf("MIDPOINT  max error %.4f mm\n", midpoint * 1000);
+        printf("RK4       max error %.4f mm\n", rk4 * 1000);
+        printf("ARC       max error %.4f mm\n", arc * 1000);
+
+#ifdef ROBUS_POSITION_FIXED_POINT
+        const double bound = 0.2e-3; // Products rounded to 1.5e-5 every update, mostly cancelling
+#else
+        const double bound = 0.01e-3;
+#endif
+        // One ARC or RK4 step per update beats the finest Euler and stays within the rounding.
+        return arc < bound && rk4 < bound && arc < euler ? 0 : 1;
+    }
+
+    struct ProfileRun {
+        double position;
+        double velocity;
+        double acceleration;
+        double deceleration;
+        double jerk;
+    };
+
+    /**
+     * @brief Drive a point mass through the motion profile and measure the limits it actually applies.
+     * @param distance Distance to stop at, negative to only follow the velocity with no stop.
+     * @param desired The velocity requested, switched to switchVelocity after switchUpdate updates.
+     */
+    ProfileRun driveProfile(double acceleration, double deceleration, double jerk, double distance, double desired,
+                            double switchVelocity, unsigned long switchUpdate, unsigned long updates, double dt) {
+        RobusPosition::MotionProfile<RobusPosition::PositionScalar> profile;
+        profile.setLimits(RobusPosition::PositionScalar((float) acceleration), RobusPosition::PositionScalar((float) deceleration),
+                          RobusPosition::PositionScalar((float) jerk));
+        ProfileRun run = {0, 0, 0, 0, 0};
+        double previousAcceleration = 0;
+        for (unsigned long update = 0; update < updates; update++) {
+            // Past the target the distance left is zero, a negative one would lift the brake cap.
+            double remaining = distance < 0 ? -1 : fmax(distance - run.position, 0);
+            float velocity = (float) profile.update(RobusPosition::PositionScalar((float) (update < switchUpdate ? desired : switchVelocity)),
+                                            RobusPosition::PositionScalar((float) remaining), RobusPosition::PositionScalar((float) dt));
+            double applied = (velocity - run.velocity) / dt;
+            // Speeding up or slowing down, as seen from the direction of travel.
+            bool speedingUp = run.velocity != 0 ? (applied > 0) == (run.velocity > 0) : true;
+            if (speedingUp) {
+                run.acceleration = fmax(run.acceleration, fabs(applied));
+            } else {
+                run.deceleration = fmax(run.deceleration, fabs(applied));
+            }
+            run.jerk = fmax(run.jerk, fabs(applied - previousAcceleration) / dt);
+            previousAcceleration = applied;
+            run.velocity = velocity;
+            run.position += velocity * dt;
+        }
+        return run;
+    }
+
+    int runProfile(unsigned long ticks, unsigned long period) {
+        struct Case {
+            const char *name;
+            double acceleration;
+            double deceleration;
+            double jerk;
+            double distance;
+        };
+        const Case cases[] = {
+            {"trapezoid", 0.5, 0.5, 0, 1},
+            {"trapezoid", 1, 0.3, 0, 0.2},
+            {"jerk", 0.5, 0.5, 2, 1},
+            {"jerk", 0.5, 0.5, 2, 0.3},
+            {"jerk", 0.5, 1, 5, 0.05},
+            {"jerk", 0.5, 0.5, 2, 0.02}
+        };
+        double dt = period / 1000000.0;
+        unsigned long updates = std::min(ticks, (unsigned long) (20 / dt));
+#ifdef ROBUS_POSITION_FIXED_POINT
+        const double overshoot = 0.5e-3; // The velocity is rounded to 1.5e-5 m/s every update
+        const double slack = 0.1;        // Of the jerk limit, the applied acceleration is rounded as well
+#else
+        const double overshoot = 0.05e-3;
+        const double slack = 0.05;
+#endif
+        bool passed = true;
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            const Case &c = cases[i];
+            ProfileRun run = driveProfile(c.acceleration, c.deceleration, c.jerk, c.distance, 0.3, 0.3, updates, updates, dt);
+            double past = run.position - c.distance;
+            bool ok = fabs(run.velocity) < 1e-6 && past < overshoot && past > -5e-3 &&
+                      run.acceleration <= c.acceleration * 1.01 && run.deceleration <= c.deceleration * 1.01 &&
+                      (c.jerk == 0 || run.jerk <= c.jerk * (1 + slack));
+            printf("%-9s %.2f m, accel %.2f decel %.2f jerk %.0f: stopped %+.3f mm from the target, "
+                   "accel %.3f decel %.3f jerk %.2f%s\n", c.name, c.distance, c.acceleration, c.deceleration, c.jerk,
+                   past * 1000, run.acceleration, run.deceleration, c.jerk == 0 ? 0 : run.jerk, ok ? "" : "  FAIL");
+            passed = passed && ok;
+        }
+
+        // Reverse from cruise with no target: the jerk still holds through the sign change and it settles.
+        ProfileRun reverse = driveProfile(0.5, 0.5, 2, -1, 0.3, -0.2, 100, updates, dt);
+        bool ok = fabs(reverse.velocity + 0.2) < 1e-3 && reverse.acceleration <= 0.505 && reverse.deceleration <= 0.505 &&
+                  reverse.jerk <= 2 * (1 + slack);
+        printf("reverse   0.3 to -0.2 m/s: settled at %.4f m/s, accel %.3f decel %.3f jerk %.2f%s\n", reverse.velocity,
+               reverse.acceleration, reverse.deceleration, reverse.jerk, ok ? "" : "  FAIL");
+        return passed && ok ? 0 : 1;
+    }
+
+    struct VelocityRun {
+        double countError;
+        double rawError;
+        double filteredError;
+        double rawWorst;
+    };
+
+    /**
+     * @brief Latch an encoder at 1 kHz and return the RMS errors of the count-per-dt speed and of the estimator.
+     * @param speed Wheel speed in ticks per second at a time in seconds.
+     *
+     * The count starts 50 ticks short of the LS7366_COUNTER_BYTES wrap. Each latch comes up to 50 us late
+     * and is timed by micros() at 4 us, like the encoder sampler. The first 100 ms are left out.
+     */
+    VelocityRun driveVelocity(double (*speed)(double), unsigned long samples) {
+        const double wrap = ldexp(1.0, 8 * LS7366_COUNTER_BYTES - 1);
+        const float alpha = 0.3;
+        VelocityEstimator raw, filtered;
+        filtered.setFilter(alpha, alpha * alpha / (2 - alpha));
+        double position = wrap - 50;
+        double latchTime = 0;
+        // The counter reads the count sign-extended from its width.
+        int32_t previous = LS7366Counter::delta((int32_t) (int64_t) floor(position), 0);
+        raw.reset(previous, 0);
+        filtered.reset(previous, 0);
+
+        srand(1);
+        VelocityRun run = {0, 0, 0, 0};
+        unsigned long measured = 0;
+        for (unsigned long sample = 1; sample <= samples; sample++) {
+            double time = sample * 1e-3 + 50e-6 * rand() / RAND_MAX;
+            // Midpoint step of the position from the last latch.
+            position += speed((latchTime + time) / 2) * (time - latchTime);
+            latchTime = time;
+            int32_t count = LS7366Counter::delta((int32_t) (int64_t) floor(position), 0);
+            uint32_t timestamp = (uint32_t) (time * 1e6) & ~3UL;
+            raw.update(count, timestamp);
+            filtered.update(count, timestamp);
+            double countSpeed = LS7366Counter::delta(count, previous) * 1000.0;
+            previous = count;
+            if (sample <= 100) {
+                continue;
+            }
+            double truth = speed(time);
+            run.countError += (countSpeed - truth) * (countSpeed - truth);
+            run.rawError += (raw.getVelocity() - truth) * (raw.getVelocity() - truth);
+            run.filteredError += (filtered.getVelocity() - truth) * (filtered.getVelocity() - truth);
+            run.rawWorst = fmax(run.rawWorst, fabs(raw.getVelocity() - truth));
+            measured++;
+        }
+        run.countError = sqrt(run.countError / measured);
+        run.rawError = sqrt(run.rawError / measured);
+        run.filteredError = sqrt(run.filteredError / measured);
+        return run;
+    }
+
+    double slowSpeed(double) {
+        return 40;
+    }
+
+    double fastSpeed(double) {
+        return 400;
+    }
+
+    double reversingSpeed(double time) {
+        // Back and forth across the wrap, through zero twice a second.
+        return 400 * cos(PI * time);
+    }
+
+    int runVelocity(unsigned long ticks, unsigned long) {
+        struct Case {
+            const char *name;
+            double (*speed)(double);
+        };
+        const Case cases[] = {
+            {"40/s", slowSpeed},
+            {"400/s", fastSpeed},
+            {"reverse", reversingSpeed}
+        };
+        unsigned long samples = std::min(ticks, 60000UL);
+        printf("%d-byte counter, RMS error in ticks/s\n", LS7366_COUNTER_BYTES);
+        bool passed = true;
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            VelocityRun run = driveVelocity(cases[i].speed, samples);
+            // A wrap taken for a jump of the count shows as an error of the whole counter range per millisecond.
+            bool ok = run.rawError < run.countError && run.rawWorst < 1000;
+            printf("%-9s count per dt %.2f, estimator %.2f, filtered %.2f, worst estimate %.1f%s\n", cases[i].name,
+                   run.countError, run.rawError, run.filteredError, run.rawWorst, ok ? "" : "  FAIL");
+            passed = passed && ok;
+        }
+        return passed ? 0 : 1;
+    }
+
+#ifndef ROBUS_POSITION_NO_MAP
+    int runMap(unsigned long ticks, unsigned long period) {
+        setup();
+        setupArena();
+        RobusPosition::OccupancyGrid &grid = RobusPosition::getOccupancyGrid();
+        grid.setGeometry(-0.6, -0.6, 0.05);
+
+        RobusPosition::clearWaypoints();
+        RobusPosition::addWaypoint(1, 0);
+        RobusPosition::addWaypoint(1, 1);
+        RobusPosition::addWaypoint(0, 1);
+        RobusPosition::addWaypoint(0, 0);
+        RobusPosition::startFollowingTarget();
+
+        srand(1);
+        for (unsigned long tick = 0; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+            if (tick % 5 == 0) {
+                RobusPosition::mapWithSonar(tick / 5 % 2);
+            }
+        }
+
+        // Occupied cells should only be found along the walls, at x or y = -0.5 or 1.5.
+        unsigned wallCells = 0, strayCells = 0, freeCells = 0;
+        for (int16_t row = grid.getSize() - 1; row >= 0; row--) {
+            for (int16_t column = 0; column < grid.getSize(); column++) {
+                RobusPosition::CellState state = grid.getCell(column, row);
+                float x, y;
+                grid.cellToWorld(column, row, x, y);
+                bool nearWall = (fabs(x + 0.5) < 0.06 || fabs(x - 1.5) < 0.06 || fabs(y + 0.5) < 0.06 || fabs(y - 1.5) < 0.06)
+                                && x > -0.56 && x < 1.56 && y > -0.56 && y < 1.56;
+                if (state >= RobusPosition::CELL_LIKELY) {
+                    nearWall ? wallCells++ : strayCells++;
+                } else if (state == RobusPosition::CELL_FREE) {
+                    freeCells++;
+                }
+                putchar(" .?#"[state == RobusPosition::CELL_UNKNOWN ? 0 : state == RobusPosition::CELL_FREE ? 1 : state == RobusPosition::CELL_LIKELY ? 2 : 3]);
+            }
+            putchar('\n');
+        }
+        printf("occupied cells on the walls: %u, elsewhere: %u, free cells: %u\n", wallCells, strayCells, freeCells);
+        return strayCells * 10 < wallCells ? 0 : 1;
+    }
+
+    /**
+     * @brief Distance from a point to the segment between (x1, y1) and (x2, y2).
+     */
+    double segmentDistance(double x, double y, double x1, double y1, double x2, double y2) {
+        double dx = x2 - x1, dy = y2 - y1;
+        double along = fmax(0, fmin(1, ((x - x1) * dx + (y - y1) * dy) / (dx * dx + dy * dy)));
+        return hypot(x - x1 - along * dx, y - y1 - along * dy);
+    }
+
+    int runPlan(unsigned long ticks, unsigned long period) {
+        setup();
+        setupArena();
+        // Only the plant knows this wall, the robot has to find it.
+        Simulation::addWall(0.6, -0.5, 0.6, 0.8);
+        RobusPosition::getOccupancyGrid().setGeometry(-0.6, -0.6, 0.05);
+
+        RobusPosition::PlanResult result = RobusPosition::planPath(1.2, 0);
+        printf("first plan: result %d, %u waypoints\n", result, RobusPosition::getWaypointCount());
+
+        srand(1);
+        Simulation::DifferentialDrive &robot = Simulation::robot();
+        unsigned replans = 0, bumps = 0;
+        double clearance = 1e9;
+        unsigned long tick = 0;
+        for (; tick < ticks && RobusPosition::isPlanActive(); tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+            if (tick % 5 == 0) {
+                RobusPosition::mapWithSonar(tick / 5 % 2);
+                replans += RobusPosition::replanIfBlocked();
+            }
+
+            double distance = segmentDistance(robot.getX(), robot.getY(), 0.6, -0.5, 0.6, 0.8);
+            clearance = fmin(clearance, distance);
+            if (distance < BUMPER_DISTANCE && fabs(robot.getX() + BUMPER_DISTANCE * cos(robot.getTrueOrientation()) - 0.6) < 0.02) {
+                bumps++;
+                replans += RobusPosition::reportBumper(FRONT);
+            }
+        }
+
+        RobusPosition::Vector position = RobusPosition::getPosition();
+        printf("%lu ticks (%.3f s), %u replans, %u bumps, closest to the wall %.3f\n",
+               tick, tick * period / 1000000.0, replans, bumps, clearance);
+        printf("final position: %.3f %.3f, true %.3f %.3f\n", position.x, position.y, robot.getX(), robot.getY());
+        return !RobusPosition::isPlanActive() && clearance > 0.05 && hypot(robot.getX() - 1.2, robot.getY()) < 0.05 ? 0 : 1;
+    }
+#endif
+
+    /**
+     * @brief Drive a calibration square and return the true end error in the start frame.
+     */
+    double driveCalibrationSquare(unsigned long ticks, unsigned long period, bool clockwise, float &errorX, float &errorY) {
+        Simulation::DifferentialDrive &robot = Simulation::robot();
+        double startX = robot.getX(), startY = robot.getY(), startOrientation = robot.getTrueOrientation();
+
+        RobusPosition::startCalibrationRun(clockwise);
+        for (unsigned long tick = 0; tick < ticks && RobusPosition::isCalibrationRunning(); tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+        }
+
+        double dx = robot.getX() - startX, dy = robot.getY() - startY;
+        errorX = dx * cos(startOrientation) + dy * sin(startOrientation);
+        errorY = -dx * sin(startOrientation) + dy * cos(startOrientation);
+        return hypot(errorX, errorY);
+    }
+
+    /**
+     * @brief Drive one square in each direction, return the larger end error.
+     */
+    double driveCalibrationPair(unsigned long ticks, unsigned long period, const char *label) {
+        double worst = 0;
+        for (int clockwise = 0; clockwise < 2; clockwise++) {
+            float errorX, errorY;
+            worst = fmax(worst, driveCalibrationSquare(ticks, period, clockwise, errorX, errorY));
+            RobusPosition::addCalibrationRun(clockwise, errorX, errorY);
+            printf("%s %-16s end error %.4f %.4f\n", label, clockwise ? "clockwise:" : "counterclockwise:", errorX, errorY);
+        }
+        return worst;
+    }
+
+    int runCalibrate(unsigned long ticks, unsigned long period) {
+        setup();
+        Simulation::DifferentialDrive &robot = Simulation::robot();
+        robot.leftScale = 1.006;
+        robot.rightScale = 0.994;
+        robot.trackScale = 1.03;
+        RobusPosition::setOdometrySource(RobusPosition::ENCODER_TICKS);
+        RobusPosition::setWheelCalibration(RobusPosition::WheelCalibration());
+        RobusPosition::setCalibrationSquare(1);
+
+        double before = driveCalibrationPair(ticks, period, "before:");
+        RobusPosition::applyCalibration();
+        RobusPosition::WheelCalibration calibration = RobusPosition::getWheelCalibration();
+        printf("calibration: left %.4f right %.4f track %.4f\n", calibration.leftScale, calibration.rightScale, calibration.trackScale);
+        double after = driveCalibrationPair(ticks, period, "after: ");
+
+        // The next boot restores the same calibration.
+        RobusPosition::setWheelCalibration(RobusPosition::WheelCalibration());
+        bool loaded = RobusPosition::loadParameters();
+        RobusPosition::WheelCalibration restored = RobusPosition::getWheelCalibration();
+        loaded &= memcmp(&restored, &calibration, sizeof(calibration)) == 0;
+        printf("worst end error before %.4f, after %.4f, restored from EEPROM: %s\n", before, after, loaded ? "yes" : "no");
+        return loaded && after < before / 4 ? 0 : 1;
+    }
+
+    int runPersist(unsigned long ticks, unsigned long period) {
+        setup();
+        RobusPosition::setFollowVelocity(0.25);
+        RobusPosition::setFollowAngularVelocityScale(2.5);
+        RobusPosition::setCurveTightness(30);
+        RobusPosition::setInverted(true);
+        RobusPosition::saveParameters();
+
+        RobusPosition::setFollowVelocity(1);
+        RobusPosition::setFollowAngularVelocityScale(1);
+        RobusPosition::setCurveTightness(10);
+        RobusPosition::setInverted(false);
+        bool parameters = RobusPosition::loadParameters() && RobusPosition::getFollowVelocity() == 0.25f &&
+                          RobusPosition::getFollowAngularVelocityScale() == 2.5f && RobusPosition::getCurveTightness() == 30 &&
+                          RobusPosition::isInverted();
+        RobusPosition::setInverted(false);
+        printf("parameters restored: %s\n", parameters ? "yes" : "no");
+
+        // Drive around the square, saving the pose more times than there are slots.
+        RobusPosition::clearWaypoints();
+        RobusPosition::addWaypoint(1, 0);
+        RobusPosition::addWaypoint(1, 1);
+        RobusPosition::addWaypoint(0, 1);
+        RobusPosition::startFollowingTarget();
+        RobusPosition::PoseSnapshot saved = RobusPosition::PoseSnapshot();
+        RobusPosition::PoseSnapshot previous = RobusPosition::PoseSnapshot();
+        unsigned saves = 0;
+        uint8_t before[E2END + 1];
+        uint16_t lastChanged = 0;
+        for (unsigned long tick = 0; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+            if (tick % 50 == 0) {
+                previous = saved;
+                saved = RobusPosition::getPoseSnapshot();
+                for (uint16_t i = 0; i <= E2END; i++) {
+                    before[i] = EEPROM.read(i);
+                }
+                RobusPosition::savePose();
+                for (uint16_t i = 0; i <= E2END; i++) {
+                    if (EEPROM.read(i) != before[i]) {
+                        lastChanged = i;
+                    }
+                }
+                saves++;
+            }
+        }
+
+        RobusPosition::setPosition(5, 5);
+        bool pose = RobusPosition::loadPose() && RobusPosition::getPosition().x == saved.x &&
+                    RobusPosition::getPosition().y == saved.y && fabs(RobusPosition::getOrientation() - saved.orientation) < 1e-5;
+        printf("%u poses saved in %u slots, newest restored: %s\n", saves, POSE_STORE_SLOTS, pose ? "yes" : "no");
+
+        // A reset during the last write leaves its slot corrupted, the pose before it is restored.
+        EEPROM.write(lastChanged, EEPROM.read(lastChanged) ^ 0x5A);
+        bool torn = RobusPosition::loadPose() && RobusPosition::getPosition().x == previous.x && RobusPosition::getPosition().y == previous.y;
+        printf("torn write falls back to the previous pose: %s\n", torn ? "yes" : "no");
+        return parameters && pose && torn ? 0 : 1;
+    }
+
+#ifdef ROBUS_POSITION_RECORDER
+    int runRecord(unsigned long ticks, unsigned long period) {
+        setup();
+        RobusPosition::clearWaypoints();
+        RobusPosition::addWaypoint(1, 0);
+        RobusPosition::addWaypoint(1, 1);
+        RobusPosition::addWaypoint(0, 1);
+        RobusPosition::addWaypoint(0, 0);
+        RobusPosition::startRecording();
+        RobusPosition::startFollowingTarget();
+
+        for (unsigned long tick = 0; tick < ticks && RobusPosition::getWaypointCount() > 0; tick++) {
+            Simulation::advance(period);
+            RobusPosition::update();
+        }
+        RobusPosition::dumpRecording();
+        return 0;
+    }
+
+    int runReplay(const char *path) {
+        FILE *file = path ? fopen(path, "rb") : NULL;
+        if (!file) {
+            fprintf(stderr, "cannot open %s\n", path ? path : "(no file)");
+            return 2;
+        }
+        uint8_t buffer[RECORDER_HEADER_SIZE];
+        RobusPosition::RecordHeader header;
+        if (fread(buffer, 1, RECORDER_HEADER_SIZE, file) != RECORDER_HEADER_SIZE || !RobusPosition::Recorder::decodeHeader(buffer, header)) {
+            fprintf(stderr, "%s is not a recording of this version\n", path);
+            fclose(file);
+            return 2;
+        }
+        std::vector<RobusPosition::RecordEntry> entries(header.count);
+        for (uint16_t i = 0; i < header.count; i++) {
+            if (fread(buffer, 1, RECORDER_ENTRY_SIZE, file) != RECORDER_ENTRY_SIZE) {
+                fprintf(stderr, "%s is truncated after %u entries\n", path, i);
+                fclose(file);
+                return 2;
+            }
+            RobusPosition::Recorder::decodeEntry(buffer, entries[i]);
+        }
+        fclose(file);
+        if (entries.empty()) {
+            fprintf(stderr, "%s holds no update\n", path);
+            return 2;
+        }
+
+        setup();
+        RobusPosition::setParameters(header.parameters);
+        RobusPosition::setIntegrator((RobusPosition::Integrator) header.integrator);
+        RobusPosition::startReplay(entries[0]);
+
+        unsigned mismatches = 0;
+        double deviation = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 1; i < entries.size(); i++) {
+            // Same dt as the recorded update computed, from the clock or the nominal period.
+            const RobusPosition::RecordEntry &entry = entries[i];
+            unsigned long period = header.fixedRateFrequency ? 1000000UL / header.fixedRateFrequency : 0;
+            float dt = period ? period / 1000000.0 : (unsigned long) (entry.inputs.time - entries[i - 1].inputs.time) / 1000000.0;
+            RobusPosition::replayUpdate(entry, dt);
+
+            RobusPosition::PoseSnapshot pose = RobusPosition::getPoseSnapshot();
+            if (memcmp(&pose.x, &entry.x, sizeof(float)) || memcmp(&pose.y, &entry.y, sizeof(float)) ||
+                memcmp(&pose.orientation, &entry.orientation, sizeof(float))) {
+                mismatches++;
+                deviation = fmax(deviation, hypot(pose.x - entry.x, pose.y - entry.y));
+            }
+        }
+        double wall = elapsedSeconds(start);
+
+        printf("%zu updates replayed, %u differ from the recording (largest position deviation %.3g)\n",
+               entries.size() - 1, mismatches, deviation);
+        printf("%.1f ns per update\n", wall * 1e9 / (entries.size() - 1));
+        return mismatches == 0 ? 0 : 1;
+    }
+#endif
+
+    int runBenchmark(unsigned long ticks, unsigned long period) {
+        setup();
+        RobusPosition::startFollowingTarget();
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+        FixedPoint::floatToFixedCount = 0;
+        FixedPoint::fixedToFloatCount = 0;
+#endif
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned long tick = 0; tick < ticks; tick++) {
+            // Move the target around a circle so the follower never settles.
+            float angle = tick * period / 1000000.0f;
+            RobusPosition::setTarget(cos(angle), sin(angle));
+            Simulation::advance(period);
+            RobusPosition::update();
+        }
+        double wall = elapsedSeconds(start);
+
+        printf("%lu ticks, %.3f s simulated, %.3f s wall, %.0f ticks/s\n",
+               ticks, ticks * period / 1000000.0, wall, ticks / wall);
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+        // Left at the float API and snapshot boundary of the fixed-point engine.
+        printf("conversions per tick: %.1f float to Q16.16, %.1f Q16.16 to float\n",
+               (double) FixedPoint::floatToFixedCount / ticks, (double) FixedPoint::fixedToFloatCount / ticks);
+#endif
+        return 0;
+    }
+
+    // Courses of the sweep, each from the origin facing +X.
+    const float SWEEP_TARGETS[][2] = {{1, 0}, {0, 1}, {-1, 0}, {1, 1}, {0.3f, -0.5f}};
+    const uint8_t SWEEP_COURSES = sizeof(SWEEP_TARGETS) / sizeof(SWEEP_TARGETS[0]);
+    const double SWEEP_TIMEOUT = 30;  // Seconds before a course counts as missed
+    const double SWEEP_SETTLE = 0.5;  // Seconds simulated after the stop, to measure the overshoot
+
+    struct SweepConfiguration {
+        float velocity;
+        float angularVelocityScale;
+        float curveTightness;
+    };
+
+    struct SweepResult {
+        SweepConfiguration configuration;
+        uint8_t reached;   // Courses where the follower stopped on the target
+        double time;       // Sum of the times to target, in seconds
+        double overshoot;  // Largest true distance past a target along its course
+        double pathLength; // Sum of the true distances travelled
+        double error;      // Largest true distance from a target after settling
+    };
+
+    /**
+     * @brief Drive every course with its own follower, odometry and plant.
+     *
+     * Nothing global is touched, so the configurations run in parallel. The update mirrors
+     * RobusPosition::tick() with encoder odometry.
+     */
+    SweepResult runSweepConfiguration(const SweepConfiguration &configuration, unsigned long ticks, unsigned long period) {
+        SweepResult result = {configuration, 0, 0, 0, 0, 0};
+        double dt = period / 1000000.0;
+        unsigned long limit = std::min(ticks, (unsigned long) (SWEEP_TIMEOUT / dt));
+        unsigned long settleTicks = (unsigned long) (SWEEP_SETTLE / dt);
+
+        for (uint8_t course = 0; course < SWEEP_COURSES; course++) {
+            float targetX = SWEEP_TARGETS[course][0];
+            float targetY = SWEEP_TARGETS[course][1];
+            float length = dist(0, 0, targetX, targetY);
+
+            Simulation::DifferentialDrive drive;
+            RobusPosition::PositionOdometry odometry;
+            RobusPosition::PositionFollower follower;
+            odometry.setEncoderGeometry(drive.distancePerTick, drive.trackWidth, 0);
+            odometry.resetTicks(drive.readEncoder(LEFT), drive.readEncoder(RIGHT), 0);
+            follower.setVelocity(configuration.velocity);
+            follower.setAngularVelocityScale(configuration.angularVelocityScale);
+            follower.setCurveTightness(configuration.curveTightness);
+            follower.setTarget(targetX, targetY);
+            follower.start(0);
+
+            double lastX = 0, lastY = 0;
+            bool stopped = false;
+            unsigned long stopTick = 0;
+            for (unsigned long tick = 0; tick < limit; tick++) {
+                drive.step(dt);
+
+                float orientation = odometry.getTickOrientation();
+                float distance, rotation;
+                odometry.readTicks(drive.readEncoder(LEFT), drive.readEncoder(RIGHT), distance, rotation);
+                odometry.update(RobusPosition::PositionScalar(orientation), RobusPosition::PositionScalar(distance),
+                                RobusPosition::PositionScalar(rotation));
+
+                result.pathLength += dist(lastX, lastY, drive.getX(), drive.getY());
+                lastX = drive.getX();
+                lastY = drive.getY();
+                double past = ((lastX - targetX) * targetX + (lastY - targetY) * targetY) / length;
+                result.overshoot = std::max(result.overshoot, past);
+
+                if (stopped) {
+                    if (tick - stopTick >= settleTicks) {
+                        break;
+                    }
+                    continue;
+                }
+
+                float velocity, angularVelocity;
+                if (follower.update(odometry.getX(), odometry.getY(), RobusPosition::PositionScalar(odometry.getTickOrientation()),
+                                    dt, velocity, angularVelocity)) {
+                    drive.setCommand(velocity, angularVelocity);
+                } else {
+                    drive.setCommand(0, 0);
+                    stopped = true;
+                    stopTick = tick;
+                    result.reached++;
+                }
+            }
+
+            result.time += (stopped ? stopTick + 1 : limit) * dt;
+            result.error = std::max(result.error, (double) dist(lastX, lastY, targetX, targetY));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Run the configurations on a pool of one thread per core, then print the results.
+     *
+     * Each thread takes the next configuration until none is left. The rows are sorted by the
+     * courses reached, then by the total time to target.
+     */
+    int runSweepConfigurations(const std::vector<SweepConfiguration> &configurations, unsigned long ticks, unsigned long period) {
+        std::vector<SweepResult> results(configurations.size());
+        std::atomic<size_t> next(0);
+        unsigned threadCount = SWEEP_THREADS ? SWEEP_THREADS : std::max(1u, std::thread::hardware_concurrency());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < threadCount; i++) {
+            pool.push_back(std::thread([&]() {
+                for (size_t index = next++; index < configurations.size(); index = next++) {
+                    results[index] = runSweepConfiguration(configurations[index], ticks, period);
+                }
+            }));
+        }
+        for (size_t i = 0; i < pool.size(); i++) {
+            pool[i].join();
+        }
+        double wall = elapsedSeconds(start);
+
+        std::sort(results.begin(), results.end(), [](const SweepResult &a, const SweepResult &b) {
+            return a.reached != b.reached ? a.reached > b.reached : a.time < b.time;
+        });
+
+        printf("velocity scale tightness reached time_s overshoot_mm path_m error_mm\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const SweepResult &result = results[i];
+            printf("%8.3f %5.2f %9.1f %4u/%u %6.2f %12.1f %6.3f %8.1f\n",
+                   result.configuration.velocity, result.configuration.angularVelocityScale,
+                   result.configuration.curveTightness, result.reached, SWEEP_COURSES, result.time,
+                   result.overshoot * 1000, result.pathLength, result.error * 1000);
+        }
+        printf("%zu configurations x %u courses on %u threads in %.3f s wall\n",
+               results.size(), SWEEP_COURSES, threadCount, wall);
+        return results.empty() || results[0].reached < SWEEP_COURSES ? 1 : 0;
+    }
+
+    int runSweep(unsigned long ticks, unsigned long period) {
+        const float velocities[] = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f};
+        const float scales[] = {0.5f, 1, 2, 3, 5};
+        const float tightnesses[] = {5, 10, 20, 50, 100};
+
+        std::vector<SweepConfiguration> configurations;
+        for (float velocity : velocities) {
+            for (float scale : scales) {
+                for (float tightness : tightnesses) {
+                    SweepConfiguration configuration = {velocity, scale, tightness};
+                    configurations.push_back(configuration);
+                }
+            }
+        }
+        return runSweepConfigurations(configurations, ticks, period);
+    }
+
+    int runSearch(unsigned long ticks, unsigned long period) {
+        // Drawn before the pool starts, rand() is not thread safe and the seed keeps runs comparable.
+        srand(1);
+        std::vector<SweepConfiguration> configurations;
+        for (int i = 0; i < 200; i++) {
+            SweepConfiguration configuration;
+            configuration.velocity = 0.1f + 0.5f * rand() / RAND_MAX;
+            configuration.angularVelocityScale = 0.3f * pow(8 / 0.3f, (float) rand() / RAND_MAX);
+            configuration.curveTightness = 2 * pow(100.0f, (float) rand() / RAND_MAX);
+            configurations.push_back(configuration);
+        }
+        return runSweepConfigurations(configurations, ticks, period);
+    }
+
+    const Scenario SCENARIOS[] = {
+        {"square", runSquare},
+        {"waypoints", runWaypoints},
+        {"fixedrate", runFixedRate},
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+        {"history", runHistory},
+#endif
+        {"filter", runFilter},
+#ifndef ROBUS_POSITION_NO_MAP
+        {"map", runMap},
+        {"plan", runPlan},
+#endif
+        {"calibrate", runCalibrate},
+        {"persist", runPersist},
+#ifdef ROBUS_POSITION_RECORDER
+        {"record", runRecord},
+#endif
+        {"fastmath", runFastMath},
+        {"curve", runCurve},
+        {"integrators", runIntegrators},
+        {"profile", runProfile},
+        {"velocity", runVelocity},
+        {"benchmark", runBenchmark},
+        {"sweep", runSweep},
+        {"search", runSearch}
+    };
+}
+
+int main(int argc, char **argv) {
+    const char *name = argc > 1 ? argv[1] : "square";
+#ifdef ROBUS_POSITION_RECORDER
+    if (strcmp(name, "replay") == 0) {
+        return runReplay(argc > 2 ? argv[2] : NULL);
+    }
+#endif
+    unsigned long ticks = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    unsigned long rate = argc > 3 ? strtoul(argv[3], NULL, 10) : 100;
+    if (rate == 0) {
+        rate = 100;
+    }
+
+    for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++) {
+        if (strcmp(SCENARIOS[i].name, name) == 0) {
+            return SCENARIOS[i].run(ticks, 1000000 / rate);
+        }
+    }
+
+    fprintf(stderr, "unknown scenario: %s\n", name);
+    return 2;
+}
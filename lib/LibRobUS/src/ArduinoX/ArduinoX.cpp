@@ -89,6 +89,18 @@ int32_t ArduinoX::readResetEncoder(uint8_t id){
   }
 }
 
+int32_t ArduinoX::readDeltaEncoder(uint8_t id){
+  if(id<0 || id>1){
+    Serial.println("Invalid encoder id!");
+    return 0;
+  }
+  if(id == 0){
+    return -__encoder__[id].readDelta();// Left motor is inverted
+  }else{
+    return __encoder__[id].readDelta();
+  }
+}
+
 void ArduinoX::resetEncoder(uint8_t id){
   if(id<0 || id>1){
     Serial.println("Invalid encoder id!");
@@ -96,3 +108,27 @@ void ArduinoX::resetEncoder(uint8_t id){
   }
   __encoder__[id].reset();// Reset counter
 }
+
+// Incremented by every pair of latches, so a read can tell an interrupt latched again under it
+static volatile uint8_t latchGeneration = 0;
+
+EncoderCounts ArduinoX::readEncoders(){
+  EncoderCounts counts;
+  uint8_t sreg = SREG;
+  uint8_t generation;
+  do{
+    // Nothing between the two latches
+    noInterrupts();
+    __encoder__[LEFT].latch();
+    counts.timestamp = micros();
+    __encoder__[RIGHT].latch();
+    generation = ++latchGeneration;
+    SREG = sreg;
+
+    // The OTR reads run with interrupts, an encoder sampler or fixed-rate update latching
+    // meanwhile leaves counts newer than the timestamp: latch and read again.
+    counts.left = -__encoder__[LEFT].readLatched();// Left motor is inverted
+    counts.right = __encoder__[RIGHT].readLatched();
+  }while(generation != latchGeneration);
+  return counts;
+}
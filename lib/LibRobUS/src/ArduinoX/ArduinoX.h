@@ -15,6 +15,15 @@ Class to interface some of the ArduinoX "on board" functionnalities
 
 #define LEFT 0
 #define RIGHT 1
+
+// Counts of both encoders taken at the same instant
+struct EncoderCounts
+{
+  int32_t left;
+  int32_t right;
+  uint32_t timestamp; // micros() at the latch
+};
+
 class ArduinoX
 {
   public:
@@ -97,6 +106,16 @@ class ArduinoX
     @return number of pulses
     */
     int32_t readResetEncoder(uint8_t id);
+
+    /** Method read the count of pulses from a quadrature encoder
+     * since the last call, without resetting the counter.
+
+    @param id
+    identification of encoder [0,1]
+
+    @return number of pulses since the last call
+    */
+    int32_t readDeltaEncoder(uint8_t id);
     
     /** Method read reset the count of pulses to zero
     
@@ -105,6 +124,14 @@ class ArduinoX
     */
     void resetEncoder(uint8_t id);
 
+    /** Method read the count of pulses from both quadrature encoders
+    @note both counters are latched back to back before being read,
+    so the left and right counts are taken within a few microseconds
+
+    @return both counts and the time of the latch
+    */
+    EncoderCounts readEncoders();
+
   private:
     const uint8_t LOWBAT_PIN =  12;
     const uint8_t BUZZER_PIN =  36;
@@ -0,0 +1,87 @@
+/*
+Projet S1 2018
+Class to sample both encoders at a fixed rate from a timer interrupt
+@version 1.0 16/10/2026
+*/
+
+#include "EncoderSampler.h"
+#include <SPI.h>
+#include <util/atomic.h>
+
+#define SAMPLER_MASK (ENCODER_SAMPLER_SIZE - 1)
+#define TIMER5_TICKS_PER_SECOND (F_CPU / 8) // Timer5 at clk/8
+
+// Keeps the compiler from moving the buffer accesses across the index updates
+#define SAMPLER_BARRIER() asm volatile("" ::: "memory")
+
+EncoderSampler::EncoderSampler(){
+  head_ = 0;
+  tail_ = 0;
+  dropped_ = 0;
+  period_ = 0;
+  read_ = NULL;
+};
+
+void EncoderSampler::start(uint16_t frequency, EncoderCounts (*read)()){
+  read_ = read;
+  period_ = TIMER5_TICKS_PER_SECOND / constrain(frequency, 31, 5000);
+
+  // A transaction of loop() must not be cut by the reads of the interrupt
+  SPI.usingInterrupt(255);
+
+  uint8_t sreg = SREG;
+  noInterrupts();
+  dropped_ = 0;
+  // Keep the timer if it already counts free at clk/8 (IR receiver, fixed-rate mode)
+  if((TCCR5A & (_BV(WGM51) | _BV(WGM50))) || (TCCR5B & 0x1F) != _BV(CS51)){
+    TCCR5A = 0;
+    TCCR5B = _BV(CS51);
+  }
+  OCR5C = TCNT5 + period_;
+  TIFR5 = _BV(OCF5C);
+  TIMSK5 |= _BV(OCIE5C);
+  SREG = sreg;
+};
+
+void EncoderSampler::stop(){
+  // Read-modify-write of a mask shared with the other Timer5 users
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    TIMSK5 &= ~_BV(OCIE5C);
+  }
+};
+
+bool EncoderSampler::pop(EncoderCounts &sample){
+  uint8_t tail = tail_;
+  if(tail == head_){
+    return false;
+  }
+  sample = buffer_[tail & SAMPLER_MASK];
+  SAMPLER_BARRIER();
+  tail_ = tail + 1; // Single byte write, the interrupt sees the slot free only now
+  return true;
+};
+
+uint16_t EncoderSampler::getDropped() const{
+  uint8_t sreg = SREG;
+  noInterrupts();
+  uint16_t dropped = dropped_;
+  SREG = sreg;
+  return dropped;
+};
+
+void EncoderSampler::sample(){
+  uint8_t head = head_;
+  if((uint8_t)(head - tail_) >= ENCODER_SAMPLER_SIZE){
+    dropped_++;
+    return;
+  }
+  buffer_[head & SAMPLER_MASK] = read_();
+  SAMPLER_BARRIER();
+  head_ = head + 1;
+};
+
+ISR(TIMER5_COMPC_vect){
+  // Scheduled from the last compare, a late interrupt does not shift the next samples
+  OCR5C += __sampler__.getPeriod();
+  __sampler__.sample();
+};
@@ -0,0 +1,88 @@
+/*
+Projet S1 2018
+Class to sample both encoders at a fixed rate from a timer interrupt
+@version 1.0 16/10/2026
+
+The samples are taken by the Timer5 compare C interrupt, Timer5 counting free at clk/8. The IR
+receiver shares it on compare A and the fixed-rate mode of RobusPosition on compare B, none of
+them resets the count. Timer1 is not usable, the servos reset it every 20 ms. The interrupt is
+the only writer of the ring buffer and loop() the only reader, so neither side ever blocks the
+other.
+*/
+
+#ifndef EncoderSampler_H_
+#define EncoderSampler_H_
+
+#include <Arduino.h>
+#include <ArduinoX/ArduinoX.h>
+
+#ifndef ENCODER_SAMPLER_SIZE
+#define ENCODER_SAMPLER_SIZE 16 // Samples kept until loop() reads them, a power of 2 up to 128
+#endif
+
+#if (ENCODER_SAMPLER_SIZE & (ENCODER_SAMPLER_SIZE - 1)) || ENCODER_SAMPLER_SIZE > 128
+#error "ENCODER_SAMPLER_SIZE must be a power of 2 up to 128"
+#endif
+
+class EncoderSampler
+{
+  public:
+    EncoderSampler();
+
+    /** Method to start sampling
+
+    @param frequency
+    samples per second [31, 5000]
+
+    @param read
+    function reading both encoders, called from the interrupt
+    */
+    void start(uint16_t frequency, EncoderCounts (*read)());
+
+    /** Method to stop sampling, the samples not read yet are kept
+    */
+    void stop();
+
+    /** Method to take the oldest sample
+
+    @param sample
+    receives the sample
+
+    @return false if there is no sample
+    */
+    bool pop(EncoderCounts &sample);
+
+    /** Method to get the number of samples waiting
+
+    @return number of samples [0, ENCODER_SAMPLER_SIZE]
+    */
+    uint8_t available() const{ return (uint8_t)(head_ - tail_); };
+
+    /** Method to get the number of samples dropped because the buffer was full
+
+    @return number of samples dropped since start()
+    */
+    uint16_t getDropped() const;
+
+    /** Method called by the interrupt to take a sample
+    */
+    void sample();
+
+    /** Method to get the sampling period
+
+    @return Timer5 ticks between two samples
+    */
+    uint16_t getPeriod() const{ return period_; };
+
+  private:
+    EncoderCounts buffer_[ENCODER_SAMPLER_SIZE];
+    volatile uint8_t head_; // Next slot written, only changed by sample()
+    volatile uint8_t tail_; // Next slot read, only changed by pop()
+    volatile uint16_t dropped_;
+    uint16_t period_; // Timer5 ticks between two samples
+    EncoderCounts (*read_)();
+};
+
+extern EncoderSampler __sampler__;
+
+#endif //EncoderSampler
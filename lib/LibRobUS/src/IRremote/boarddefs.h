@@ -384,13 +384,18 @@
 //---------------------------------------------------------
 // Timer5 (16 bits)
 //
+// The receiver does not reset Timer5: it counts free at clk/8 and compare A is moved one tick
+// ahead on each interrupt, so compare B and C stay free for other periodic interrupts
+// (fixed-rate mode of RobusPosition, encoder sampler). Sending takes the whole timer.
+//
 #elif defined(IR_USE_TIMER5)
 
-#define TIMER_RESET
+#define TIMER_RECV_TICKS         (SYSCLOCK / 8 * USECPERTICK / 1000000)
+#define TIMER_RESET         (OCR5A += TIMER_RECV_TICKS)
 #define TIMER_ENABLE_PWM    (TCCR5A |= _BV(COM5A1))
 #define TIMER_DISABLE_PWM   (TCCR5A &= ~(_BV(COM5A1)))
-#define TIMER_ENABLE_INTR   (TIMSK5 = _BV(OCIE5A))
-#define TIMER_DISABLE_INTR  (TIMSK5 = 0)
+#define TIMER_ENABLE_INTR   (TIMSK5 |= _BV(OCIE5A))
+#define TIMER_DISABLE_INTR  (TIMSK5 &= ~_BV(OCIE5A))
 #define TIMER_INTR_NAME     TIMER5_COMPA_vect
 
 #define TIMER_CONFIG_KHZ(val) ({ \
@@ -403,9 +408,8 @@
 
 #define TIMER_CONFIG_NORMAL() ({ \
   TCCR5A = 0; \
-  TCCR5B = _BV(WGM52) | _BV(CS50); \
-  OCR5A = SYSCLOCK * USECPERTICK / 1000000; \
-  TCNT5 = 0; \
+  TCCR5B = _BV(CS51); \
+  OCR5A = TCNT5 + TIMER_RECV_TICKS; \
 })
 
 //-----------------
@@ -6,10 +6,20 @@ Class to communicate to LS7366 encoder module
 */
 #include "LS7366Counter.h"
 
+namespace {
+  // LS7366 samples MOSI on the rising edge of SCK
+  const SPISettings LS7366_SPI_SETTINGS(LS7366_SPI_CLOCK, MSBFIRST, SPI_MODE0);
+
+  // Shift that sign-extends a LS7366_COUNTER_BYTES wide count to 32 bits
+  const uint8_t EXTEND_SHIFT = 32 - 8 * LS7366_COUNTER_BYTES;
+}
+
 void LS7366Counter::init(uint8_t slave_pin, uint8_t flag_pin)
 {
   SLAVE_PIN_ = slave_pin;
   FLAG_PIN_ = flag_pin;
+  slavePort_ = portOutputRegister(digitalPinToPort(SLAVE_PIN_));
+  slaveMask_ = digitalPinToBitMask(SLAVE_PIN_);
 
   pinMode(SLAVE_PIN_, OUTPUT);    // Set slave pin as output
   pinMode(FLAG_PIN_, INPUT);      // Set flag pin as inpout
@@ -20,48 +30,71 @@ void LS7366Counter::init(uint8_t slave_pin, uint8_t flag_pin)
   // Set encoder configuration
 
     // Communication when slave pin is low.
-    digitalWrite(SLAVE_PIN_, LOW);
+    SPI.beginTransaction(LS7366_SPI_SETTINGS);
+    select();
     SPI.transfer(0x88);                // Write to MDR0
-    SPI.transfer(0x03);                // 4 bytes mode
-    digitalWrite(SLAVE_PIN_, HIGH);
+    SPI.transfer(0x03);                // x4 quadrature, free running
+    deselect();
+    select();
+    SPI.transfer(0x90);                // Write to MDR1
+    SPI.transfer(4 - LS7366_COUNTER_BYTES); // Counter width, 0 for 4 bytes
+    deselect();
+    SPI.endTransaction();
     delayMicroseconds(500);
     reset(); // Reset encoder to zero
 
 }
 
-int32_t LS7366Counter::read() {
-  uint32_t count[4];
-  int32_t count_value = 0;
-  // If id is out of range
-  digitalWrite(SLAVE_PIN_,LOW);        // Start communication
-  SPI.transfer(0x60);                     // Read command
-
-  // Read 4 bytes
-  for(uint8_t i = 0; i < 4; i++) {
-    count[i] = SPI.transfer(0x00);
+void LS7366Counter::changeSlave(bool selected) {
+  // Read-modify-write of a port shared with other pins
+  uint8_t sreg = SREG;
+  noInterrupts();
+  if(selected){
+    *slavePort_ &= ~slaveMask_;
+  }else{
+    *slavePort_ |= slaveMask_;
   }
-  digitalWrite(SLAVE_PIN_, HIGH);     // End of communication
+  SREG = sreg;
+}
+
+int32_t LS7366Counter::read() {
+  return readRegister(0x60);            // Read CNTR
+}
 
-  // Concatenate the four bytes
-  for(uint8_t i = 0; i < 4; i++) {
-    count_value = (count_value << 8) + count[i];
+int32_t LS7366Counter::readRegister(uint8_t command) {
+  uint32_t count_value = 0;
+  SPI.beginTransaction(LS7366_SPI_SETTINGS);
+  select();                            // Start communication
+  SPI.transfer(command);                  // Read command
+
+  // Read the bytes of the counter, most significant first
+  for(uint8_t i = 0; i < LS7366_COUNTER_BYTES; i++) {
+    count_value = (count_value << 8) | SPI.transfer(0x00);
   }
-  return -count_value;
+  deselect();                         // End of communication
+  SPI.endTransaction();
+
+  return -((int32_t)(count_value << EXTEND_SHIFT) >> EXTEND_SHIFT);
 }
 
 void LS7366Counter::reset() {
-  digitalWrite(SLAVE_PIN_, LOW); // Start communication
+  SPI.beginTransaction(LS7366_SPI_SETTINGS);
+  select(); // Start communication
   // write to DTR
   SPI.transfer(0x98);
-  for(uint8_t i = 0; i < 4; i++) {
+  for(uint8_t i = 0; i < LS7366_COUNTER_BYTES; i++) {
     SPI.transfer(0x00); // Set register to zero
   }
-  digitalWrite(SLAVE_PIN_, HIGH); // end communication
+  deselect(); // end communication
+  SPI.endTransaction();
   delayMicroseconds(100);
 
-  digitalWrite(SLAVE_PIN_, LOW);  // Start communication
+  SPI.beginTransaction(LS7366_SPI_SETTINGS);
+  select();  // Start communication
   SPI.transfer(0xE0);                // Set Data to center
-  digitalWrite(SLAVE_PIN_, HIGH); // end communication
+  deselect(); // end communication
+  SPI.endTransaction();
+  previous_ = 0;
 }
 
 int32_t LS7366Counter::readReset() {
@@ -69,3 +102,22 @@ int32_t LS7366Counter::readReset() {
   reset();
   return buffer;
 }
+
+int32_t LS7366Counter::readDelta() {
+  int32_t count = read();
+  int32_t difference = delta(count, previous_);
+  previous_ = count;
+  return difference;
+}
+
+void LS7366Counter::latch() {
+  SPI.beginTransaction(LS7366_SPI_SETTINGS);
+  select();  // Start communication
+  SPI.transfer(0xE8);                // Load OTR from CNTR
+  deselect(); // end communication
+  SPI.endTransaction();
+}
+
+int32_t LS7366Counter::readLatched() {
+  return readRegister(0x68);            // Read OTR
+}
@@ -10,6 +10,16 @@ Class to communicate to LS7366 encoder module
 #include "Arduino.h"
 #include <SPI.h>
 
+#ifndef LS7366_SPI_CLOCK
+// SPI clock in Hz, within the SCK limit of the LS7366R datasheet at VDD = 5 V. The Mega can
+// clock 8 MHz, but that is out of the counter's specification.
+#define LS7366_SPI_CLOCK 4000000
+#endif
+
+#ifndef LS7366_COUNTER_BYTES
+#define LS7366_COUNTER_BYTES 4 // Counter width [1, 4], below 4 the counts wrap at that width
+#endif
+
 class LS7366Counter
 {
   public:
@@ -26,6 +36,8 @@ class LS7366Counter
     /** Method to read the number of steps on an encoder module
 
     @return number of steps [–2147483648, 2147483647]
+    @note with LS7366_COUNTER_BYTES below 4 the count wraps around at that width,
+    subtract counts with delta()
     */
     int32_t read();
 
@@ -34,13 +46,52 @@ class LS7366Counter
     void reset();   // Reinitialise le nombre de pulses
 
     /** Method to read the number of steps then reset
+    @note steps counted between the read and the reset are lost, prefer readDelta()
     @return number of steps [–2147483648, 2147483647]
     */
     int32_t readReset();
 
+    /** Method to read the number of steps since the last readDelta()
+    @note the counter is never reset, so no step is lost between calls
+    @return number of steps, right across the wraparound of the counter
+    */
+    int32_t readDelta();
+
+    /** Method to get the number of steps between two counts of read() or readLatched()
+    @note use it instead of a plain subtraction, it stays right when the counter wraps
+    around at LS7366_COUNTER_BYTES
+    @return count minus previous
+    */
+    static int32_t delta(int32_t count, int32_t previous){
+      // Unsigned subtraction, then sign-extended from the counter width
+      uint32_t difference = (uint32_t)count - (uint32_t)previous;
+      return (int32_t)(difference << (32 - 8 * LS7366_COUNTER_BYTES)) >> (32 - 8 * LS7366_COUNTER_BYTES);
+    };
+
+    /** Method to copy the counter into the output register (OTR)
+    @note latch every counter first, then read them with readLatched(),
+    so the counts are taken at the same instant
+    */
+    void latch();
+
+    /** Method to read the count copied by the last latch()
+    @return number of steps [–2147483648, 2147483647]
+    */
+    int32_t readLatched();
+
   private:
+    int32_t readRegister(uint8_t command);
+
+    // Slave select by direct port access, digitalWrite() takes several microseconds
+    void select(){ changeSlave(true); };
+    void deselect(){ changeSlave(false); };
+    void changeSlave(bool selected);
+
     uint8_t SLAVE_PIN_;// {34, 35}; // Slave select pins
     uint8_t FLAG_PIN_ ;// {A14, A15};
+    int32_t previous_; // Count at the last readDelta()
+    volatile uint8_t *slavePort_; // Output register of the slave pin
+    uint8_t slaveMask_;
 };
 #endif // LS7366Counter
 
@@ -15,6 +15,10 @@ Class to interface some of the ArduinoX "on board" functionnalities
   DisplayLCD __display__;
   VexQuadEncoder __vex__;
   IRrecv __irrecv__(IR_RECV_PIN);
+  EncoderSampler __sampler__;
+#ifdef LIBROBUS_PROFILER
+  Profiler __profiler__;
+#endif
 
 // Global variables
   // Bluetooth
@@ -35,6 +39,10 @@ void BoardInit(){
 
   // init telecommande
   __irrecv__.enableIRIn(); // Start the receiver
+
+#ifdef LIBROBUS_PROFILER
+  __profiler__.init();
+#endif
 };
 
 void AudioInit(){
@@ -55,6 +63,7 @@ void MOTOR_SetSpeed(uint8_t id, float speed){
 };
 
 int32_t ENCODER_Read(uint8_t id){
+  PROFILER_SCOPE(PROFILER_ENCODER_READ);
   return __AX__.readEncoder(id);
 };
 
@@ -66,6 +75,32 @@ int32_t ENCODER_ReadReset(uint8_t id){
   return __AX__.readResetEncoder(id);
 };
 
+int32_t ENCODER_ReadDelta(uint8_t id){
+  PROFILER_SCOPE(PROFILER_ENCODER_READ);
+  return __AX__.readDeltaEncoder(id);
+};
+
+EncoderCounts ENCODER_ReadBoth(){
+  PROFILER_SCOPE(PROFILER_ENCODER_READ);
+  return __AX__.readEncoders();
+};
+
+void ENCODER_SamplerStart(uint16_t frequency){
+  __sampler__.start(frequency, ENCODER_ReadBoth);
+};
+
+void ENCODER_SamplerStop(){
+  __sampler__.stop();
+};
+
+bool ENCODER_SamplerRead(EncoderCounts &sample){
+  return __sampler__.pop(sample);
+};
+
+uint16_t ENCODER_SamplerDropped(){
+  return __sampler__.getDropped();
+};
+
 void AUDIO_Play(uint16_t track){
   __audio__.play(track);
 };
@@ -103,6 +138,7 @@ void AUDIO_SetVolume(float volume){
 };
 
 float SONAR_GetRange(uint8_t id){
+  PROFILER_SCOPE(PROFILER_SONAR_GET_RANGE);
   return __Robus__.getRangeSonar(id);
 };
 
@@ -111,6 +147,7 @@ void DISPLAY_SetCursor(uint8_t row, uint8_t column){
 };
 
 void DISPLAY_Printf(String msg){
+  PROFILER_SCOPE(PROFILER_DISPLAY_PRINTF);
   __display__.print(msg);
 };
 
@@ -211,11 +248,24 @@ void SOFT_TIMER_Disable(uint8_t id){
 };
 
 void SOFT_TIMER_Update(){
+  PROFILER_SCOPE(PROFILER_SOFT_TIMER_UPDATE);
   for(uint8_t id = 0; id<MAX_N_TIMER; id++){
     __timer__[id].update();
   };
 };
 
+void PROFILER_Reset(){
+#ifdef LIBROBUS_PROFILER
+  __profiler__.reset();
+#endif
+};
+
+void PROFILER_Dump(){
+#ifdef LIBROBUS_PROFILER
+  __profiler__.dump(Serial);
+#endif
+};
+
 void BLUETOOTH_print(String msg){
   SerialBT.print(msg);
 };
@@ -15,6 +15,9 @@ General librairies for Robus robot
 #include <DisplayLCD/DisplayLCD.h>
 #include <VexQuadEncoder/VexQuadEncoder.h>
 #include <SoftTimer/SoftTimer.h>
+#include <Profiler/Profiler.h>
+#include <EncoderSampler/EncoderSampler.h>
+#include <VelocityEstimator/VelocityEstimator.h>
 
 // Third party libraries
 #include <IRremote/IRremote.h>
@@ -90,6 +93,55 @@ identification of the motor (LEFT(0) or RIGHT(1))
 */
 int32_t ENCODER_ReadReset(uint8_t id);
 
+/** Function to read the number of pulses from a counter since the last call
+@note the counter is not reset, no pulse is lost between two calls
+
+@param id
+identification of the motor (LEFT(0) or RIGHT(1))
+
+@return number of pulses since the last call
+*/
+int32_t ENCODER_ReadDelta(uint8_t id);
+
+/** Function to read the number of pulses from both encoder counters
+@note the two counters are latched at the same instant, so the heading
+computed from their difference carries no skew
+@note with LS7366_COUNTER_BYTES below 4 the counts wrap at that width,
+subtract them with LS7366Counter::delta()
+
+@return left and right number of pulses, and micros() at the latch
+*/
+EncoderCounts ENCODER_ReadBoth();
+
+/** Function to start sampling both encoders from the Timer5 compare C interrupt
+@note SPI transactions then hold the interrupts, so an interrupt never cuts one
+
+@param frequency
+samples per second [31, 5000]
+*/
+void ENCODER_SamplerStart(uint16_t frequency);
+
+/** Function to stop sampling the encoders
+*/
+void ENCODER_SamplerStop();
+
+/** Function to take the oldest encoder sample
+@note call it often enough to empty the ENCODER_SAMPLER_SIZE samples buffer,
+ENCODER_SamplerDropped() counts the samples lost when it is full
+
+@param sample
+receives both counts and micros() at the latch
+
+@return false if there is no sample
+*/
+bool ENCODER_SamplerRead(EncoderCounts &sample);
+
+/** Function to get the number of encoder samples lost because the buffer was full
+
+@return number of samples lost since ENCODER_SamplerStart()
+*/
+uint16_t ENCODER_SamplerDropped();
+
 /** Function to play an audio track on mp3 player
 This function is non-blocking
 
@@ -303,6 +355,19 @@ void SOFT_TIMER_Disable(uint8_t id);
 */
 void SOFT_TIMER_Update();
 
+/** Function to clear the profiler table and restart its measuring window
+@note does nothing unless LIBROBUS_PROFILER is defined, BoardInit() starts the profiler
+*/
+void PROFILER_Reset();
+
+/** Function to print the profiler table on Serial
+@note one line per called section: name, calls, min, max and total in us,
+then the share of the measuring window in %
+
+does nothing unless LIBROBUS_PROFILER is defined
+*/
+void PROFILER_Dump();
+
 /** Function to write a message to Bluetooth module
 @note for Sunfounder Serial Bluetooth
 
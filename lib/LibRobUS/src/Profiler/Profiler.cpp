@@ -0,0 +1,101 @@
+/*
+Projet S1 2018
+Class to measure the time spent in the hot functions of the main loop
+@version 1.0 16/10/2026
+*/
+
+#include "Profiler.h"
+
+#ifdef LIBROBUS_PROFILER
+
+#include <util/atomic.h>
+
+#define PROFILER_TICKS_PER_US (F_CPU / 8000000.0) // Timer5 at clk/8
+
+namespace {
+  const char positionUpdateName[] PROGMEM = "position";
+  const char encoderReadName[] PROGMEM = "encoder";
+  const char softTimerUpdateName[] PROGMEM = "timer";
+  const char sonarGetRangeName[] PROGMEM = "sonar";
+  const char displayPrintfName[] PROGMEM = "display";
+  const char user0Name[] PROGMEM = "user0";
+  const char user1Name[] PROGMEM = "user1";
+  const char user2Name[] PROGMEM = "user2";
+
+  const char * const sectionNames[PROFILER_N_SECTION] PROGMEM = {
+    positionUpdateName, encoderReadName, softTimerUpdateName, sonarGetRangeName,
+    displayPrintfName, user0Name, user1Name, user2Name
+  };
+}
+
+void Profiler::init(){
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    // Keep the timer if it already counts free at clk/8 (IR receiver, encoder sampler, fixed-rate mode)
+    if((TCCR5A & (_BV(WGM51) | _BV(WGM50))) || (TCCR5B & 0x1F) != _BV(CS51)){
+      TCCR5A = 0;
+      TCCR5B = _BV(CS51);
+    }
+  }
+  reset();
+};
+
+void Profiler::reset(){
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    memset(sections_, 0, sizeof(sections_));
+    start_ = micros();
+  }
+};
+
+uint16_t Profiler::now(){
+  uint16_t count;
+  // The two bytes go through the TEMP register shared with the interrupts reading 16-bit timers
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    count = TCNT5;
+  }
+  return count;
+};
+
+void Profiler::record(uint8_t section, uint16_t duration){
+  Section &s = sections_[section];
+  // Sections are also measured from the interrupt of the fixed-rate mode
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    if(s.count == 0 || duration < s.min){
+      s.min = duration;
+    }
+    if(duration > s.max){
+      s.max = duration;
+    }
+    s.total += duration;
+    s.count++;
+  }
+};
+
+void Profiler::dump(Print &out){
+  uint32_t window = micros() - start_;
+  out.print(F("prof "));
+  out.print(window);
+  out.println(F(" us"));
+
+  for(uint8_t i = 0; i < PROFILER_N_SECTION; i++){
+    Section s;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      s = sections_[i];
+    }
+    if(s.count == 0){
+      continue;
+    }
+    out.print((const __FlashStringHelper *) pgm_read_word(&sectionNames[i]));
+    out.print(' ');
+    out.print(s.count);
+    out.print(' ');
+    out.print(s.min / PROFILER_TICKS_PER_US, 1);
+    out.print(' ');
+    out.print(s.max / PROFILER_TICKS_PER_US, 1);
+    out.print(' ');
+    out.print((uint32_t) (s.total / PROFILER_TICKS_PER_US));
+    out.print(' ');
+    out.println(window ? 100.0 * s.total / PROFILER_TICKS_PER_US / window : 0.0, 1);
+  }
+};
+
+#endif // LIBROBUS_PROFILER
@@ -0,0 +1,104 @@
+/*
+Projet S1 2018
+Class to measure the time spent in the hot functions of the main loop
+@version 1.0 16/10/2026
+
+Compiled only with -D LIBROBUS_PROFILER, PROFILER_SCOPE() expands to nothing otherwise.
+Durations are read from Timer5 counting free at clk/8 (0.5 us steps at 16 MHz), the timer the IR
+receiver, the encoder sampler and the fixed-rate mode of RobusPosition already share without
+resetting it. The 16-bit count wraps every 32.7 ms, a longer call such as SONAR_GetRange()
+waiting out a missing echo is recorded modulo 32.7 ms. Sending IR reconfigures Timer5. The
+measuring window comes from micros().
+*/
+
+#ifndef Profiler_H_
+#define Profiler_H_
+
+#include <Arduino.h>
+
+// Sections measured by the profiler
+#define PROFILER_POSITION_UPDATE 0
+#define PROFILER_ENCODER_READ 1
+#define PROFILER_SOFT_TIMER_UPDATE 2
+#define PROFILER_SONAR_GET_RANGE 3
+#define PROFILER_DISPLAY_PRINTF 4
+#define PROFILER_USER_0 5 // Free for the user code
+#define PROFILER_USER_1 6
+#define PROFILER_USER_2 7
+#define PROFILER_N_SECTION 8
+
+#ifdef LIBROBUS_PROFILER
+
+class Profiler
+{
+  public:
+    /** Method to clear the table, called by BoardInit(),
+    starts Timer5 at clk/8 unless it already counts free that way
+    */
+    void init();
+
+    /** Method to clear the table and restart the measuring window
+    */
+    void reset();
+
+    /** Method to read the timebase
+
+    @return TCNT5, in 0.5 us ticks, wraps around after 32.7 ms
+    */
+    static uint16_t now();
+
+    /** Method to add a call to a section
+
+    @param section
+    index of the section [0, PROFILER_N_SECTION-1]
+
+    @param duration
+    duration of the call in ticks of now()
+    */
+    void record(uint8_t section, uint16_t duration);
+
+    /** Method to print the table, one line per called section:
+    name, calls, min, max and total in us, then the share of the window in %
+
+    @param out
+    stream to print to (Serial)
+    */
+    void dump(Print &out);
+
+  private:
+    struct Section
+    {
+      uint32_t count;
+      uint16_t min;   // In ticks of now()
+      uint16_t max;
+      uint32_t total;
+    };
+
+    Section sections_[PROFILER_N_SECTION];
+    uint32_t start_; // Start of the measuring window, from micros()
+};
+
+extern Profiler __profiler__;
+
+// Measures a section until the end of the enclosing block, nested sections are counted in both
+class ProfilerScope
+{
+  public:
+    ProfilerScope(uint8_t section): section_(section), start_(Profiler::now()){};
+    // Unsigned 16-bit difference, right across a wrap of the timer
+    ~ProfilerScope(){ __profiler__.record(section_, (uint16_t)(Profiler::now() - start_)); };
+
+  private:
+    uint8_t section_;
+    uint16_t start_;
+};
+
+#define PROFILER_SCOPE(section) ProfilerScope profilerScope_(section)
+
+#else
+
+#define PROFILER_SCOPE(section)
+
+#endif // LIBROBUS_PROFILER
+
+#endif //Profiler
@@ -0,0 +1,61 @@
+/*
+Projet S1 2018
+Class to estimate the speed of a wheel from its encoder count
+@version 1.0 16/10/2026
+*/
+
+#include "VelocityEstimator.h"
+#include <LS7366Counter/LS7366Counter.h>
+
+VelocityEstimator::VelocityEstimator(){
+  window_ = 0;
+  alpha_ = 0;
+  beta_ = 0;
+  reset(0, 0);
+};
+
+void VelocityEstimator::reset(int32_t count, uint32_t time){
+  edgeCount_ = count;
+  edgeTime_ = time;
+  raw_ = 0;
+  velocity_ = 0;
+  acceleration_ = 0;
+};
+
+void VelocityEstimator::setFilter(float alpha, float beta){
+  alpha_ = alpha;
+  beta_ = beta;
+  acceleration_ = 0;
+};
+
+void VelocityEstimator::update(int32_t count, uint32_t time, uint32_t edgeTime){
+  // Right when the counter (at its LS7366_COUNTER_BYTES width) or micros() wraps around
+  int32_t edges = LS7366Counter::delta(count, edgeCount_);
+  uint32_t interval = edgeTime - edgeTime_;
+
+  if(edges != 0){
+    if(interval > 0 && interval >= window_){
+      raw_ = edges * 1000000.0f / interval;
+      edgeCount_ = count;
+      edgeTime_ = edgeTime;
+    }
+  }else{
+    // No edge yet: the wheel turns slower than one edge over the time since the last one
+    uint32_t elapsed = time - edgeTime_;
+    if(elapsed >= VELOCITY_ESTIMATOR_TIMEOUT){
+      raw_ = 0;
+    }else if(fabs(raw_) * elapsed > 1000000.0f){
+      raw_ = raw_ > 0 ? 1000000.0f / elapsed : -1000000.0f / elapsed;
+    }
+  }
+
+  if(alpha_ > 0){
+    // Steady-rate alpha-beta tracker of the speed and its change per update
+    float predicted = velocity_ + acceleration_;
+    float residual = raw_ - predicted;
+    velocity_ = predicted + alpha_ * residual;
+    acceleration_ += beta_ * residual;
+  }else{
+    velocity_ = raw_;
+  }
+};
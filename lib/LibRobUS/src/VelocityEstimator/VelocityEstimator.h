@@ -0,0 +1,106 @@
+/*
+Projet S1 2018
+Class to estimate the speed of a wheel from its encoder count
+@version 1.0 16/10/2026
+
+M/T method: the edges counted since the last edge used by an estimate, over the time between the
+two edges. At high speed many edges arrive per update and it acts as the count (M) method with
+exact timing, at low speed a single edge spans several updates and it becomes the period (T)
+method. While no edge arrives the speed is bounded by one edge over the time since the last one,
+so it falls to zero when the wheel stops. An optional alpha-beta filter tracks the result.
+
+Edge times come from the latch of the LS7366 counters (EncoderCounts::timestamp, one sampling
+period of resolution) or from the interrupt of the VexQuadEncoder (VexQuadEncoder::readEdge()).
+An update costs one float division, about 30 us on the Mega. Counts are subtracted at the
+LS7366_COUNTER_BYTES width, so a narrow counter wraps right and the count may change by up to half
+its range between two updates.
+*/
+
+#ifndef VelocityEstimator_H_
+#define VelocityEstimator_H_
+
+#include <Arduino.h>
+
+#ifndef VELOCITY_ESTIMATOR_TIMEOUT
+#define VELOCITY_ESTIMATOR_TIMEOUT 250000 // us without an edge before the speed is zero
+#endif
+
+class VelocityEstimator
+{
+  public:
+    VelocityEstimator();
+
+    /** Method to restart the estimate from a stopped wheel
+
+    @param count
+    current count of the encoder
+
+    @param time
+    time of the count in us
+    */
+    void reset(int32_t count, uint32_t time);
+
+    /** Method to add a count whose edges are timed at the latch (LS7366)
+
+    @param count
+    count of the encoder
+
+    @param time
+    micros() at the latch of the count
+    */
+    void update(int32_t count, uint32_t time){ update(count, time, time); };
+
+    /** Method to add a count with the time of its last edge (VexQuadEncoder)
+
+    @param count
+    count of the encoder
+
+    @param time
+    micros() at the update
+
+    @param edgeTime
+    micros() at the last edge counted in count
+    */
+    void update(int32_t count, uint32_t time, uint32_t edgeTime);
+
+    /** Method to get the speed, filtered when the filter is on
+
+    @return speed in ticks per second
+    */
+    float getVelocity() const{ return velocity_; };
+
+    /** Method to get the speed of the M/T method alone
+
+    @return speed in ticks per second
+    */
+    float getRawVelocity() const{ return raw_; };
+
+    /** Method to set the shortest time between the edges of an estimate
+
+    @param window
+    time in us, longer windows quantise less at medium speed but react later (0 by default)
+    */
+    void setWindow(uint32_t window){ window_ = window; };
+
+    /** Method to set the alpha-beta filter
+
+    @param alpha
+    gain of the speed [0, 1], 0 turns the filter off (default)
+
+    @param beta
+    gain of the acceleration, alpha * alpha / (2 - alpha) for a critically damped filter
+    @note the gains assume updates at a steady rate, like the encoder sampler gives
+    */
+    void setFilter(float alpha, float beta);
+
+  private:
+    int32_t edgeCount_;   // Count at the last edge used by an estimate
+    uint32_t edgeTime_;   // Time of that edge in us
+    uint32_t window_;
+    float raw_;           // M/T speed, ticks per second
+    float velocity_;      // Output speed, ticks per second
+    float acceleration_;  // Change of speed per update tracked by the filter
+    float alpha_;
+    float beta_;
+};
+#endif //VelocityEstimator
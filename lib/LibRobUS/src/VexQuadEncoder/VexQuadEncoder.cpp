@@ -19,4 +19,13 @@ void VexQuadEncoder::isr(){
   }else{
     counter_ -= 1;
   }
+  edgeTime_ = micros();
+}
+
+void VexQuadEncoder::readEdge(int32_t &count, uint32_t &edgeTime){
+  uint8_t sreg = SREG;
+  noInterrupts();
+  count = counter_;
+  edgeTime = edgeTime_;
+  SREG = sreg;
 }
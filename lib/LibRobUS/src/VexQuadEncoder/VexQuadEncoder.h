@@ -62,10 +62,21 @@ class VexQuadEncoder
     */
     void reset(){counter_=0;};
 
+    /** Method to read the counter and the time of its last change together
+
+    @param count
+    receives the counter
+
+    @param edgeTime
+    receives micros() at the last edge counted
+    */
+    void readEdge(int32_t &count, uint32_t &edgeTime);
+
   private:
     uint8_t PIN_CH1_;
     uint8_t PIN_CH2_;
     volatile int32_t counter_;
+    volatile uint32_t edgeTime_; // micros() at the last edge
 };
 #endif // VexQuadEncoder
 /*
@@ -0,0 +1,57 @@
+#include "Calibration.h"
+
+#define UMBMARK_MAX_ERROR 0.2f // Largest systematic error the small angle model accepts, in radians
+
+namespace RobusPosition
+{
+    Umbmark::Umbmark(float side) {
+        reset(side);
+    }
+
+    void Umbmark::reset(float side) {
+        side_ = side;
+        clockwiseSum_ = 0;
+        counterclockwiseSum_ = 0;
+        clockwiseRuns_ = 0;
+        counterclockwiseRuns_ = 0;
+    }
+
+    void Umbmark::addRun(bool clockwise, float errorX, float errorY) {
+        // To first order, a counterclockwise run ends at 2L(a + b) * (1, -1) and a clockwise run at
+        // 2L(a - b) * (1, 1), with a the overturn of each corner and b the bend of each leg.
+        if (clockwise) {
+            clockwiseSum_ += errorX + errorY;
+            clockwiseRuns_++;
+        } else {
+            counterclockwiseSum_ += errorX - errorY;
+            counterclockwiseRuns_++;
+        }
+    }
+
+    bool Umbmark::compute(float trackWidth, WheelCalibration &correction) const {
+        if (clockwiseRuns_ == 0 || counterclockwiseRuns_ == 0 || side_ <= 0) {
+            return false;
+        }
+        float clockwise = clockwiseSum_ / clockwiseRuns_ / (4 * side_);
+        float counterclockwise = counterclockwiseSum_ / counterclockwiseRuns_ / (4 * side_);
+        float overturn = (counterclockwise + clockwise) / 2;
+        float bend = (counterclockwise - clockwise) / 2;
+        if (fabs(overturn) > UMBMARK_MAX_ERROR || fabs(bend) > UMBMARK_MAX_ERROR) {
+            return false;
+        }
+
+        // Each corner turned HALF_PI + overturn while the odometry measured HALF_PI.
+        correction.trackScale = HALF_PI / (HALF_PI + overturn);
+
+        // Each leg is an arc turning by bend; the wheel diameter ratio follows from its radius.
+        correction.leftScale = 1;
+        correction.rightScale = 1;
+        if (bend != 0) {
+            float radius = side_ / 2 / sin(bend / 2);
+            float ratio = (radius + trackWidth / 2) / (radius - trackWidth / 2);
+            correction.leftScale = 2 / (ratio + 1);
+            correction.rightScale = 2 / (1 / ratio + 1);
+        }
+        return true;
+    }
+}
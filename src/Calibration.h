@@ -0,0 +1,70 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <Arduino.h>
+
+namespace RobusPosition
+{
+    /**
+     * @brief Wheel corrections of the encoder odometry.
+     *
+     * The ground distance of a wheel is its encoder distance times its scale, and the effective
+     * track width is the nominal one times trackScale.
+     */
+    struct WheelCalibration {
+        float leftScale;
+        float rightScale;
+        float trackScale;
+
+        WheelCalibration(float left = 1, float right = 1, float track = 1) : leftScale(left), rightScale(right), trackScale(track) {}
+    };
+
+    /**
+     * @brief UMBmark estimation of the systematic odometry errors from bidirectional square runs.
+     *
+     * The robot drives a square of the given side with odometry only, counterclockwise (left turns)
+     * and clockwise (right turns), starting and ending at the same spot. After each run, the offset
+     * of the real end position from the start is measured in the start frame: X along the first
+     * leg, Y to its left. Unequal wheel diameters bend the straight legs and a wrong track width
+     * over- or under-turns the corners; both shift the end of the two directions differently, which
+     * tells them apart. Several runs per direction are averaged.
+     */
+    class Umbmark
+    {
+      public:
+        Umbmark(float side = 1);
+
+        /**
+         * @brief Forget the runs and set the side of the square.
+         */
+        void reset(float side);
+
+        /**
+         * @brief Add the measured end error of a run.
+         * @param clockwise Whether the square turned right.
+         * @param errorX The real end position minus the start, along the first leg.
+         * @param errorY The real end position minus the start, to the left of the first leg.
+         */
+        void addRun(bool clockwise, float errorX, float errorY);
+
+        uint8_t getRunCount(bool clockwise) const { return clockwise ? clockwiseRuns_ : counterclockwiseRuns_; }
+        float getSide() const { return side_; }
+
+        /**
+         * @brief Compute the corrections, relative to the calibration used during the runs.
+         * @param trackWidth The track width used during the runs.
+         * @param correction Receives the corrections to multiply with the current calibration.
+         * @return false if a direction has no run or the errors are too large for the model.
+         */
+        bool compute(float trackWidth, WheelCalibration &correction) const;
+
+      private:
+        float side_;
+        float clockwiseSum_;        // Sum of the end errors of the clockwise runs, along the error direction of that run
+        float counterclockwiseSum_;
+        uint8_t clockwiseRuns_;
+        uint8_t counterclockwiseRuns_;
+    };
+}
+
+#endif // CALIBRATION_H
@@ -0,0 +1,141 @@
+#include "FastMath.h"
+
+#define FAST_MATH_TABLE_STEPS 64
+
+namespace FastMath
+{
+    namespace {
+        /** sin(i / 64 * PI / 2) * 65535, quarter wave. */
+        const uint16_t SIN_TABLE[FAST_MATH_TABLE_STEPS + 1] PROGMEM = {
+            0, 1608, 3216, 4821, 6424, 8022, 9616, 11204,
+            12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+            25079, 26557, 28020, 29465, 30893, 32302, 33692, 35061,
+            36409, 37736, 39039, 40319, 41575, 42806, 44011, 45189,
+            46340, 47464, 48558, 49624, 50659, 51664, 52638, 53580,
+            54490, 55367, 56211, 57021, 57797, 58537, 59243, 59913,
+            60546, 61144, 61704, 62227, 62713, 63161, 63571, 63943,
+            64276, 64570, 64826, 65042, 65219, 65357, 65456, 65515,
+            65535
+        };
+
+        /** atan(i / 64) / (PI / 4) * 65535. */
+        const uint16_t ATAN_TABLE[FAST_MATH_TABLE_STEPS + 1] PROGMEM = {
+            0, 1304, 2607, 3908, 5208, 6506, 7800, 9090,
+            10376, 11658, 12933, 14203, 15466, 16722, 17970, 19210,
+            20441, 21664, 22877, 24080, 25273, 26456, 27627, 28788,
+            29936, 31074, 32199, 33312, 34412, 35500, 36576, 37638,
+            38688, 39724, 40747, 41758, 42755, 43738, 44709, 45666,
+            46611, 47541, 48459, 49364, 50256, 51135, 52001, 52854,
+            53695, 54523, 55339, 56142, 56934, 57713, 58481, 59236,
+            59980, 60713, 61435, 62145, 62844, 63533, 64211, 64878,
+            65535
+        };
+
+        /** (sqrt(1 + (i / 64)^2) - 1) * 131070. */
+        const uint16_t HYPOT_TABLE[FAST_MATH_TABLE_STEPS + 1] PROGMEM = {
+            0, 16, 64, 144, 256, 399, 575, 782,
+            1020, 1290, 1590, 1922, 2284, 2677, 3099, 3552,
+            4034, 4545, 5085, 5654, 6251, 6876, 7528, 8207,
+            8913, 9645, 10403, 11186, 11995, 12828, 13685, 14566,
+            15471, 16398, 17348, 18319, 19313, 20327, 21363, 22418,
+            23494, 24589, 25703, 26836, 27987, 29157, 30343, 31547,
+            32768, 34004, 35257, 36526, 37810, 39109, 40422, 41750,
+            43092, 44447, 45816, 47197, 48592, 49999, 51418, 52849,
+            54291
+        };
+
+        const float STEPS_PER_RADIAN = 4 * FAST_MATH_TABLE_STEPS / TWO_PI;
+
+        // 2 * PI split in a part with 8 significant bits and the rest, so turns * TWO_PI_HIGH is exact.
+        const float TWO_PI_HIGH = 6.28125f;
+        const float TWO_PI_LOW = 0.0019353071795864769f;
+        const float ATAN_SCALE = PI / 4 / 65535;
+
+        /**
+         * @brief Interpolate linearly in a table.
+         * @param table The PROGMEM table.
+         * @param position Position in table steps, in the range [0, FAST_MATH_TABLE_STEPS].
+         * @return The interpolated raw value.
+         */
+        float interpolate(const uint16_t *table, float position) {
+            uint8_t index = (uint8_t) position;
+            if (index >= FAST_MATH_TABLE_STEPS) {
+                index = FAST_MATH_TABLE_STEPS - 1;
+            }
+            float low = pgm_read_word(&table[index]);
+            float high = pgm_read_word(&table[index + 1]);
+            return low + (high - low) * (position - index);
+        }
+
+        /**
+         * @brief Convert an angle to table steps, 4 * FAST_MATH_TABLE_STEPS per turn, in [0, 4 * FAST_MATH_TABLE_STEPS[.
+         *
+         * Removing the whole turns in radians first keeps the fraction of large angles.
+         */
+        float toSteps(float angle) {
+            float turns = floor(angle * (1 / TWO_PI));
+            angle = (angle - turns * TWO_PI_HIGH) - turns * TWO_PI_LOW;
+            return angle > 0 ? angle * STEPS_PER_RADIAN : 0;
+        }
+
+        /**
+         * @brief Sine of an angle given in table steps.
+         * @param steps The angle in table steps, positive.
+         */
+        float sinSteps(float steps) {
+            uint16_t step = (uint16_t) steps;
+            uint8_t quadrant = (step / FAST_MATH_TABLE_STEPS) & 3;
+            float position = (step % FAST_MATH_TABLE_STEPS) + (steps - step);
+            if (quadrant & 1) {
+                position = FAST_MATH_TABLE_STEPS - position;
+            }
+            float value = interpolate(SIN_TABLE, position) * (1.0f / 65535);
+            return quadrant & 2 ? -value : value;
+        }
+    }
+
+    float fastSin(float angle) {
+        return sinSteps(toSteps(angle));
+    }
+
+    float fastCos(float angle) {
+        return sinSteps(toSteps(angle) + FAST_MATH_TABLE_STEPS);
+    }
+
+    void fastSinCos(float angle, float &cosine, float &sine) {
+        float steps = toSteps(angle);
+        sine = sinSteps(steps);
+        cosine = sinSteps(steps + FAST_MATH_TABLE_STEPS);
+    }
+
+    float fastAtan2(float y, float x) {
+        float ax = fabs(x);
+        float ay = fabs(y);
+        if (ax == 0 && ay == 0) {
+            return 0;
+        }
+
+        // Reduce to the first octant, where the ratio stays in [0, 1].
+        float angle;
+        if (ay <= ax) {
+            angle = interpolate(ATAN_TABLE, ay / ax * FAST_MATH_TABLE_STEPS) * ATAN_SCALE;
+        } else {
+            angle = HALF_PI - interpolate(ATAN_TABLE, ax / ay * FAST_MATH_TABLE_STEPS) * ATAN_SCALE;
+        }
+        if (x < 0) {
+            angle = PI - angle;
+        }
+        return y < 0 ? -angle : angle;
+    }
+
+    float fastHypot(float x, float y) {
+        float ax = fabs(x);
+        float ay = fabs(y);
+        float large = ax > ay ? ax : ay;
+        float small = ax > ay ? ay : ax;
+        if (large == 0) {
+            return 0;
+        }
+        return large + large * interpolate(HYPOT_TABLE, small / large * FAST_MATH_TABLE_STEPS) * (1.0f / 131070);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <Arduino.h>
+
+/** Maximum absolute error of fastSin() and fastCos(), for |angle| < 1000 rad. */
+#define FAST_MATH_SIN_ERROR 1e-4f
+
+/** Maximum absolute error of fastAtan2(), in radians. */
+#define FAST_MATH_ATAN2_ERROR 5e-5f
+
+/** Maximum relative error of fastHypot() and fastDist(). */
+#define FAST_MATH_HYPOT_ERROR 5e-5f
+
+namespace FastMath
+{
+    /**
+     * @brief Sine from a 65-entry PROGMEM quarter-wave table with linear interpolation.
+     *
+     * A few multiplications reduce the angle and interpolate, where the avr-libc sin() evaluates
+     * a polynomial after its own reduction. Error below FAST_MATH_SIN_ERROR.
+     *
+     * @param angle The angle in radians.
+     * @return The sine of the angle.
+     */
+    float fastSin(float angle);
+
+    /**
+     * @brief Cosine from the fastSin() table, with the same error.
+     * @param angle The angle in radians.
+     * @return The cosine of the angle.
+     */
+    float fastCos(float angle);
+
+    /**
+     * @brief Compute both the cosine and the sine of an angle, sharing the range reduction.
+     * @param angle The angle in radians.
+     * @param cosine Receives the cosine of the angle.
+     * @param sine Receives the sine of the angle.
+     */
+    void fastSinCos(float angle, float &cosine, float &sine);
+
+    /**
+     * @brief Angle of a vector from an octant reduction and a 65-entry PROGMEM arctangent table.
+     *
+     * One division and one interpolation. Error below FAST_MATH_ATAN2_ERROR.
+     *
+     * @param y The Y component of the vector.
+     * @param x The X component of the vector.
+     * @return The angle in radians, in the range [-PI, PI]; 0 for the null vector.
+     */
+    float fastAtan2(float y, float x);
+
+    /**
+     * @brief Length of a vector as max(|x|, |y|) * sqrt(1 + r^2), r = min / max, read from a table.
+     *
+     * One division and one interpolation, no square root. Relative error below FAST_MATH_HYPOT_ERROR.
+     *
+     * @param x The X component of the vector.
+     * @param y The Y component of the vector.
+     * @return The length of the vector.
+     */
+    float fastHypot(float x, float y);
+
+    /**
+     * @brief Distance between two points with fastHypot().
+     */
+    inline float fastDist(float x1, float y1, float x2, float y2) {
+        return fastHypot(x2 - x1, y2 - y1);
+    }
+}
+
+#endif // FAST_MATH_H
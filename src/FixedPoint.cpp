@@ -0,0 +1,233 @@
+#include "FixedPoint.h"
+
+#define CORDIC_ITERATION 16
+
+namespace FixedPoint
+{
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+    uint32_t floatToFixedCount = 0;
+    uint32_t fixedToFloatCount = 0;
+#endif
+
+    namespace {
+        /** atan(2^-i) in Q16.16. */
+        const int32_t CORDIC_ANGLES[CORDIC_ITERATION] PROGMEM = {
+            51472, 30386, 16055, 8150, 4091, 2047, 1024, 512,
+            256, 128, 64, 32, 16, 8, 4, 2
+        };
+
+        /** CORDIC gain compensation 0.607252935 in Q2.30. */
+        const int32_t CORDIC_GAIN_Q30 = 652032874;
+
+        /** CORDIC gain compensation 0.607252935 in Q16.16. */
+        const int32_t CORDIC_GAIN = 39797;
+
+        int32_t cordicAngle(uint8_t i) {
+            return (int32_t) pgm_read_dword(&CORDIC_ANGLES[i]);
+        }
+    }
+
+    Fixed operator/(Fixed a, Fixed b) {
+        bool negative = (a.raw < 0) != (b.raw < 0);
+        uint32_t dividend = a.raw < 0 ? -(uint32_t) a.raw : a.raw;
+        uint32_t divisor = b.raw < 0 ? -(uint32_t) b.raw : b.raw;
+        if (divisor == 0) {
+            return Fixed::fromRaw(negative ? -0x7FFFFFFFL : 0x7FFFFFFFL);
+        }
+
+        uint32_t quotient = dividend / divisor;
+        uint32_t remainder = dividend - quotient * divisor;
+        for (uint8_t i = 0; i < 16; i++) {
+            // remainder < divisor <= 2^31, so the shift cannot overflow.
+            remainder <<= 1;
+            quotient <<= 1;
+            if (remainder >= divisor) {
+                remainder -= divisor;
+                quotient |= 1;
+            }
+        }
+
+        // Round to nearest.
+        if (remainder >= divisor - remainder) {
+            quotient++;
+        }
+        return Fixed::fromRaw(negative ? -(int32_t) quotient : (int32_t) quotient);
+    }
+
+    void sincos(Fixed angle, Fixed &cosine, Fixed &sine) {
+        int32_t z = angle.raw % FIXED_TWO_PI.raw;
+        if (z > FIXED_PI.raw) {
+            z -= FIXED_TWO_PI.raw;
+        } else if (z < -FIXED_PI.raw) {
+            z += FIXED_TWO_PI.raw;
+        }
+
+        // CORDIC only converges in [-PI/2, PI/2], fold the other half-plane with a sign flip.
+        bool flip = false;
+        if (z > FIXED_HALF_PI.raw) {
+            z -= FIXED_PI.raw;
+            flip = true;
+        } else if (z < -FIXED_HALF_PI.raw) {
+            z += FIXED_PI.raw;
+            flip = true;
+        }
+
+        // Rotate in Q2.30 to keep precision through the shifts.
+        int32_t x = CORDIC_GAIN_Q30;
+        int32_t y = 0;
+        for (uint8_t i = 0; i < CORDIC_ITERATION; i++) {
+            int32_t dx = x >> i;
+            int32_t dy = y >> i;
+            if (z >= 0) {
+                x -= dy;
+                y += dx;
+                z -= cordicAngle(i);
+            } else {
+                x += dy;
+                y -= dx;
+                z += cordicAngle(i);
+            }
+        }
+
+        cosine = Fixed::fromRaw(flip ? -(x >> 14) : (x >> 14));
+        sine = Fixed::fromRaw(flip ? -(y >> 14) : (y >> 14));
+    }
+
+    Fixed sin(Fixed angle) {
+        Fixed cosine, sine;
+        sincos(angle, cosine, sine);
+        return sine;
+    }
+
+    Fixed cos(Fixed angle) {
+        Fixed cosine, sine;
+        sincos(angle, cosine, sine);
+        return cosine;
+    }
+
+    void polar(Fixed x, Fixed y, Fixed &magnitude, Fixed &angle) {
+        int32_t vx = x.raw;
+        int32_t vy = y.raw;
+        int32_t z = 0;
+
+        if (vx == 0 && vy == 0) {
+            magnitude = Fixed();
+            angle = Fixed();
+            return;
+        }
+
+        // Bring the vector in the right half-plane, where CORDIC converges.
+        if (vx < 0) {
+            z = vy >= 0 ? FIXED_PI.raw : -FIXED_PI.raw;
+            vx = -vx;
+            vy = -vy;
+        }
+
+        // Scale small vectors up so the shifts below do not eat their precision.
+        int8_t scale = 0;
+        while (vx < (1L << 28) && vy < (1L << 28) && vy > -(1L << 28)) {
+            vx <<= 1;
+            vy <<= 1;
+            scale++;
+        }
+        while (vx >= (1L << 29) || vy >= (1L << 29) || vy <= -(1L << 29)) {
+            vx >>= 1;
+            vy >>= 1;
+            scale--;
+        }
+
+        for (uint8_t i = 0; i < CORDIC_ITERATION; i++) {
+            int32_t dx = vx >> i;
+            int32_t dy = vy >> i;
+            if (vy > 0) {
+                vx += dy;
+                vy -= dx;
+                z += cordicAngle(i);
+            } else {
+                vx -= dy;
+                vy += dx;
+                z -= cordicAngle(i);
+            }
+        }
+
+        int32_t length = (Fixed::fromRaw(vx) * Fixed::fromRaw(CORDIC_GAIN)).raw;
+        magnitude = Fixed::fromRaw(scale >= 0 ? length >> scale : length << -scale);
+
+        if (z > FIXED_PI.raw) {
+            z -= FIXED_TWO_PI.raw;
+        } else if (z < -FIXED_PI.raw) {
+            z += FIXED_TWO_PI.raw;
+        }
+        angle = Fixed::fromRaw(z);
+    }
+
+    Fixed atan2(Fixed y, Fixed x) {
+        Fixed magnitude, angle;
+        polar(x, y, magnitude, angle);
+        return angle;
+    }
+
+    Fixed hypot(Fixed x, Fixed y) {
+        Fixed magnitude, angle;
+        polar(x, y, magnitude, angle);
+        return magnitude;
+    }
+
+    Fixed sqrt(Fixed value) {
+        if (value.raw <= 0) {
+            return Fixed();
+        }
+
+        // sqrt(raw / 2^16) * 2^16 = sqrt(raw * 2^16): find the 24 result bits in two passes,
+        // shifting the remainder between them so 32 bits are enough.
+        uint32_t remainder = value.raw;
+        uint32_t result = 0;
+        uint32_t bit = 1UL << 30;
+        while (bit > remainder) {
+            bit >>= 2;
+        }
+
+        for (uint8_t pass = 0; pass < 2; pass++) {
+            while (bit) {
+                if (remainder >= result + bit) {
+                    remainder -= result + bit;
+                    result = (result >> 1) + bit;
+                } else {
+                    result >>= 1;
+                }
+                bit >>= 2;
+            }
+
+            if (pass == 0) {
+                if (remainder > 65535) {
+                    // The remainder would overflow, move half of the result in it first.
+                    remainder -= result;
+                    remainder = (remainder << 16) - 0x8000;
+                    result = (result << 16) + 0x8000;
+                } else {
+                    remainder <<= 16;
+                    result <<= 16;
+                }
+                bit = 1UL << 14;
+            }
+        }
+
+        // Round to nearest.
+        if (remainder > result) {
+            result++;
+        }
+        return Fixed::fromRaw(result);
+    }
+
+    Fixed pow(Fixed base, uint8_t exponent) {
+        Fixed result = 1;
+        while (exponent) {
+            if (exponent & 1) {
+                result *= base;
+            }
+            base *= base;
+            exponent >>= 1;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <Arduino.h>
+
+namespace FixedPoint
+{
+#ifdef FIXED_POINT_COUNT_CONVERSIONS
+    // Conversions between float and Fixed done at run time, literals folded by the compiler are not counted.
+    extern uint32_t floatToFixedCount;
+    extern uint32_t fixedToFloatCount;
+#define FIXED_POINT_COUNT(counter, value) (__builtin_constant_p(value) ? (void) 0 : (void) counter++)
+#else
+#define FIXED_POINT_COUNT(counter, value) ((void) 0)
+#endif
+
+    /**
+     * @brief Signed Q16.16 fixed-point number.
+     *
+     * Range is [-32768, 32768[ with a resolution of 1/65536. Arithmetic wraps on overflow,
+     * so positions and velocities must stay well inside that range.
+     */
+    struct Fixed {
+        Fixed() : raw(0) {}
+        Fixed(int value) : raw((int32_t) value << 16) {}
+        explicit Fixed(float value) : raw((int32_t) (value * 65536.0f + (value < 0 ? -0.5f : 0.5f))) {
+            FIXED_POINT_COUNT(floatToFixedCount, value);
+        }
+
+        /**
+         * @brief Build a fixed-point number from its raw Q16.16 representation.
+         * @param raw The raw value.
+         * @return The fixed-point number.
+         */
+        static Fixed fromRaw(int32_t raw) {
+            Fixed value;
+            value.raw = raw;
+            return value;
+        }
+
+        /**
+         * @brief Convert a duration in microseconds to seconds.
+         * @param us The duration in microseconds.
+         * @return The duration in seconds.
+         */
+        static Fixed fromMicros(unsigned long us) {
+            // 4295 / 2^16 = 0.065536, the number of raw units per microsecond.
+            return fromRaw((int32_t) (((uint64_t) us * 4295) >> 16));
+        }
+
+        float toFloat() const {
+            FIXED_POINT_COUNT(fixedToFloatCount, raw);
+            return raw / 65536.0f;
+        }
+
+        explicit operator float() const {
+            return toFloat();
+        }
+
+        Fixed operator-() const { return fromRaw(-raw); }
+
+        Fixed &operator+=(Fixed other) { raw += other.raw; return *this; }
+        Fixed &operator-=(Fixed other) { raw -= other.raw; return *this; }
+        Fixed &operator*=(Fixed other);
+        Fixed &operator/=(Fixed other);
+
+        int32_t raw;
+    };
+
+    /**
+     * @brief Q16.16 multiplication using only 32-bit products, rounded to nearest.
+     *
+     * Splitting both operands in 16-bit halves avoids the 64-bit multiply helper, which is slow on AVR.
+     * Only the low partial product is shifted out, rounding it keeps the result from drifting toward -inf.
+     */
+    inline Fixed operator*(Fixed a, Fixed b) {
+        int32_t ah = a.raw >> 16;
+        int32_t bh = b.raw >> 16;
+        uint32_t al = (uint16_t) a.raw;
+        uint32_t bl = (uint16_t) b.raw;
+
+        return Fixed::fromRaw((int32_t) ((uint32_t) (ah * bh) << 16)
+                              + ah * (int32_t) bl
+                              + (int32_t) al * bh
+                              + (int32_t) ((al * bl + 0x8000) >> 16));
+    }
+
+    /**
+     * @brief Q16.16 division using only 32-bit arithmetic, rounded to nearest.
+     *
+     * One 32-bit division for the integer part, then the 16 fraction bits by shift and subtract,
+     * the 64-bit division helper is far slower on AVR. Division by zero saturates.
+     */
+    Fixed operator/(Fixed a, Fixed b);
+
+    /**
+     * @brief Division by an integer, rounded to nearest so repeated steps do not drift toward zero.
+     */
+    inline Fixed operator/(Fixed a, int b) {
+        int32_t half = (b < 0 ? -b : b) / 2;
+        return Fixed::fromRaw((a.raw < 0 ? a.raw - half : a.raw + half) / b);
+    }
+
+    inline Fixed operator+(Fixed a, Fixed b) { return Fixed::fromRaw(a.raw + b.raw); }
+    inline Fixed operator-(Fixed a, Fixed b) { return Fixed::fromRaw(a.raw - b.raw); }
+
+    inline Fixed &Fixed::operator*=(Fixed other) { return *this = *this * other; }
+    inline Fixed &Fixed::operator/=(Fixed other) { return *this = *this / other; }
+
+    inline bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    inline bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    inline bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    inline bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+    inline bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    inline bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+
+    const Fixed FIXED_PI = Fixed::fromRaw(205887);
+    const Fixed FIXED_HALF_PI = Fixed::fromRaw(102944);
+    const Fixed FIXED_TWO_PI = Fixed::fromRaw(411775);
+
+    /**
+     * @brief Vector structure in fixed-point.
+     */
+    struct FixedVector {
+        Fixed x;
+        Fixed y;
+    };
+
+    /**
+     * @brief Compute both the cosine and the sine of an angle with CORDIC.
+     * @param angle The angle in radians.
+     * @param cosine Receives the cosine of the angle.
+     * @param sine Receives the sine of the angle.
+     */
+    void sincos(Fixed angle, Fixed &cosine, Fixed &sine);
+
+    Fixed sin(Fixed angle);
+    Fixed cos(Fixed angle);
+
+    /**
+     * @brief Compute both the length and the angle of a vector with CORDIC.
+     * @param x The X component of the vector.
+     * @param y The Y component of the vector.
+     * @param magnitude Receives the length of the vector.
+     * @param angle Receives the angle of the vector in radians, in the range [-PI, PI].
+     */
+    void polar(Fixed x, Fixed y, Fixed &magnitude, Fixed &angle);
+
+    Fixed atan2(Fixed y, Fixed x);
+    Fixed hypot(Fixed x, Fixed y);
+
+    /**
+     * @brief Compute the square root of a number bit by bit with 32-bit integers.
+     * @param value The number, negative values return 0.
+     * @return The square root of the number.
+     */
+    Fixed sqrt(Fixed value);
+
+    /**
+     * @brief Raise a number to an integer power by repeated squaring.
+     * @param base The base.
+     * @param exponent The exponent.
+     * @return base^exponent.
+     */
+    Fixed pow(Fixed base, uint8_t exponent);
+}
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,325 @@
+#ifndef FOLLOWER_H
+#define FOLLOWER_H
+
+#include <Arduino.h>
+#include <mathX.h>
+#include "FixedPoint.h"
+#include "FastMath.h"
+#include "Integration.h"
+#include "MotionProfile.h"
+#include "SpeedCurve.h"
+#include "WaypointQueue.h"
+
+namespace RobusPosition
+{
+    // Helper function to normalize an angle to the range [0, 2*PI]
+    inline float normalizeAngle(float angle) {
+        while (angle < 0) {
+            angle += TWO_PI;
+        }
+        while (angle >= TWO_PI) {
+            angle -= TWO_PI;
+        }
+        return angle;
+    }
+
+    inline float smallestSignedAngle(float currentAngle, float targetAngle) {
+        // Ensure both angles are in the range [0, 2*PI]
+        currentAngle = normalizeAngle(currentAngle);
+        targetAngle = normalizeAngle(targetAngle);
+
+        // Calculate the difference between the angles
+        float angleDifference = targetAngle - currentAngle;
+
+        // Normalize the angle difference to be in the range [-PI, PI]
+        if (angleDifference > PI) {
+            angleDifference -= TWO_PI;
+        } else if (angleDifference < -PI) {
+            angleDifference += TWO_PI;
+        }
+
+        return angleDifference;
+    }
+
+    inline FixedPoint::Fixed normalizeAngle(FixedPoint::Fixed angle) {
+        angle.raw %= FixedPoint::FIXED_TWO_PI.raw;
+        if (angle < 0) {
+            angle += FixedPoint::FIXED_TWO_PI;
+        }
+        return angle;
+    }
+
+    inline FixedPoint::Fixed smallestSignedAngle(FixedPoint::Fixed currentAngle, FixedPoint::Fixed targetAngle) {
+        FixedPoint::Fixed angleDifference = normalizeAngle(targetAngle) - normalizeAngle(currentAngle);
+
+        if (angleDifference > FixedPoint::FIXED_PI) {
+            angleDifference -= FixedPoint::FIXED_TWO_PI;
+        } else if (angleDifference < -FixedPoint::FIXED_PI) {
+            angleDifference += FixedPoint::FIXED_TWO_PI;
+        }
+
+        return angleDifference;
+    }
+
+    /**
+     * @brief atan2() used by the follower, FastMath::fastAtan2() with ROBUS_POSITION_FAST_MATH.
+     */
+    inline float positionAtan2(float y, float x) {
+#ifdef ROBUS_POSITION_FAST_MATH
+        return FastMath::fastAtan2(y, x);
+#else
+        return atan2(y, x);
+#endif
+    }
+
+    /**
+     * @brief dist() used by the follower, FastMath::fastDist() with ROBUS_POSITION_FAST_MATH.
+     */
+    inline float positionDist(float x1, float y1, float x2, float y2) {
+#ifdef ROBUS_POSITION_FAST_MATH
+        return FastMath::fastDist(x1, y1, x2, y2);
+#else
+        return dist(x1, y1, x2, y2);
+#endif
+    }
+
+    /**
+     * @brief Length and angle of a vector, a single CORDIC run in Q16.16.
+     */
+    inline void positionPolar(float x, float y, float &magnitude, float &angle) {
+        magnitude = positionDist(0, 0, x, y);
+        angle = positionAtan2(y, x);
+    }
+
+    inline void positionPolar(FixedPoint::Fixed x, FixedPoint::Fixed y, FixedPoint::Fixed &magnitude, FixedPoint::Fixed &angle) {
+        FixedPoint::polar(x, y, magnitude, angle);
+    }
+
+    /**
+     * @brief Target and waypoint follower of a differential-drive robot.
+     *
+     * Computes the velocity and angular velocity that bring the robot on a target, or along a
+     * waypoint path with pure pursuit, from the pose given to each update. The control runs in
+     * Scalar, float or FixedPoint::Fixed; the path bookkeeping stays in float. No hardware is
+     * touched, the caller sends the command to the motors.
+     */
+    template<typename Scalar>
+    class Follower
+    {
+      public:
+        Follower() : following_(false), targetX_(0), targetY_(0), velocity_(3), angularVelocityScale_(3.0),
+                     curveTightness_(50), speedCurve_(50), inverted_(false), segmentStartX_(0), segmentStartY_(0),
+                     completedWaypoints_(0), lookaheadDistance_(0.15f), pursuingPath_(false),
+                     queuedPathLength_(0), pathRemainingDistance_(0) {}
+
+        /**
+         * @brief Compute the command for this update.
+         * @param x The X-coordinate of the robot.
+         * @param y The Y-coordinate of the robot.
+         * @param orientation The orientation of the robot, in radians.
+         * @param dt Elapsed time since the last update, in seconds.
+         * @param velocity Receives the velocity to command.
+         * @param angularVelocity Receives the angular velocity to command, in radians per second.
+         * @return false if the robot is on the target and must stop.
+         */
+        bool update(Scalar x, Scalar y, Scalar orientation, float dt, float &velocity, float &angularVelocity) {
+            updateWaypoints((float) x, (float) y);
+
+            Scalar targetDistance, targetAngle;
+            positionPolar(Scalar(targetX_) - x, Scalar(targetY_) - y, targetDistance, targetAngle);
+            if (!(targetDistance > Scalar(0.01f))) {
+                profile_.reset();
+                return false;
+            }
+
+            Scalar deltaOrientation = smallestSignedAngle(orientation, targetAngle);
+
+            // Precomputed pow(cos(deltaOrientation), curveTightness), zero past a quarter turn.
+            Scalar speedFactor = speedCurve_.evaluate(deltaOrientation);
+            Scalar remainingDistance = pursuingPath_ ? Scalar(pathRemainingDistance_) : targetDistance;
+            Scalar command = profile_.update(speedFactor * Scalar(inverted_ ? -velocity_ : velocity_), remainingDistance, Scalar(dt));
+            Scalar turn = deltaOrientation * Scalar(angularVelocityScale_);
+
+            if (pursuingPath_) {
+                // Pure pursuit: follow the arc through the lookahead point, turn in place while misaligned.
+                Scalar curvature = Scalar(2) * positionSin(deltaOrientation) / targetDistance;
+                turn = speedFactor * Scalar(fabs(velocity_)) * curvature + (Scalar(1) - speedFactor) * turn;
+            }
+
+            velocity = (float) command;
+            angularVelocity = clamp((float) turn, -0.5, 0.5);
+            return true;
+        }
+
+        /**
+         * @brief Start following, the velocity profile starts from the current velocity.
+         * @param currentVelocity The velocity of the robot.
+         */
+        void start(float currentVelocity) {
+            profile_.reset(Scalar(currentVelocity));
+            following_ = true;
+        }
+
+        void stop() { following_ = false; }
+        bool isFollowing() const { return following_; }
+        void setFollowing(bool following) { following_ = following; }
+
+        void setTarget(float x, float y) {
+            targetX_ = x;
+            targetY_ = y;
+        }
+
+        float getTargetX() const { return targetX_; }
+        float getTargetY() const { return targetY_; }
+
+        /**
+         * @brief Append a waypoint to the path.
+         * @param x The X-coordinate of the waypoint.
+         * @param y The Y-coordinate of the waypoint.
+         * @param currentX The X-coordinate of the robot, start of the path if the queue is empty.
+         * @param currentY The Y-coordinate of the robot.
+         * @return false if the waypoint queue is full.
+         */
+        bool addWaypoint(float x, float y, float currentX, float currentY) {
+            if (waypoints_.isEmpty()) {
+                segmentStartX_ = currentX;
+                segmentStartY_ = currentY;
+            } else if (!waypoints_.isFull()) {
+                float lastX, lastY;
+                waypoints_.get(waypoints_.count() - 1, lastX, lastY);
+                queuedPathLength_ += positionDist(lastX, lastY, x, y);
+            }
+            return waypoints_.push(x, y);
+        }
+
+        /**
+         * @brief Remove all the waypoints and reset the progress.
+         */
+        void clearWaypoints() {
+            waypoints_.clear();
+            queuedPathLength_ = 0;
+            completedWaypoints_ = 0;
+            pursuingPath_ = false;
+        }
+
+        uint8_t getWaypointCount() const { return waypoints_.count(); }
+        void getWaypoint(uint8_t i, float &x, float &y) const { waypoints_.get(i, x, y); }
+        uint16_t getCompletedWaypoints() const { return completedWaypoints_; }
+
+        void setLookaheadDistance(float distance) { lookaheadDistance_ = distance; }
+        float getLookaheadDistance() const { return lookaheadDistance_; }
+
+        void setVelocity(float velocity) { velocity_ = velocity; }
+        float getVelocity() const { return velocity_; }
+
+        void setAngularVelocityScale(float scale) { angularVelocityScale_ = scale; }
+        float getAngularVelocityScale() const { return angularVelocityScale_; }
+
+        /**
+         * @brief Set the tightness of the curve, rebuilding the speed curve table if it changed.
+         * @param tightness The exponent of the cosine of the heading error.
+         */
+        void setCurveTightness(float tightness) {
+            if (tightness != curveTightness_) {
+                setCurveTightness(tightness, SpeedCurve(tightness));
+            }
+        }
+
+        /**
+         * @brief Set the tightness of the curve with its table already built, only copying it.
+         * @param curve The table, SpeedCurve(tightness).
+         */
+        void setCurveTightness(float tightness, const SpeedCurve &curve) {
+            curveTightness_ = tightness;
+            speedCurve_ = curve;
+        }
+
+        float getCurveTightness() const { return curveTightness_; }
+
+        void setProfile(float acceleration, float deceleration, float jerk) {
+            profile_.setLimits(Scalar(acceleration), Scalar(deceleration), Scalar(jerk));
+        }
+
+        float getAcceleration() const { return (float) profile_.getAcceleration(); }
+        float getDeceleration() const { return (float) profile_.getDeceleration(); }
+        float getJerk() const { return (float) profile_.getJerk(); }
+
+        void setInverted(bool inverted) { inverted_ = inverted; }
+        bool isInverted() const { return inverted_; }
+
+      private:
+        /**
+         * @brief Move the target to the lookahead point on the waypoint path.
+         *
+         * Waypoints closer than the lookahead distance are passed without stopping, only the last one
+         * is reached like a regular target.
+         */
+        void updateWaypoints(float currentX, float currentY) {
+            float endX, endY;
+
+            while (!waypoints_.isEmpty()) {
+                waypoints_.get(0, endX, endY);
+                float remaining = positionDist(currentX, currentY, endX, endY);
+                bool last = waypoints_.count() == 1;
+                if ((last && remaining > 0.01) || (!last && remaining > lookaheadDistance_)) {
+                    break;
+                }
+                segmentStartX_ = endX;
+                segmentStartY_ = endY;
+                waypoints_.pop();
+                completedWaypoints_++;
+
+                if (!waypoints_.isEmpty()) {
+                    float nextX, nextY;
+                    waypoints_.get(0, nextX, nextY);
+                    queuedPathLength_ -= positionDist(endX, endY, nextX, nextY);
+                }
+            }
+
+            if (waypoints_.isEmpty()) {
+                pursuingPath_ = false;
+                queuedPathLength_ = 0;
+                return;
+            }
+            pathRemainingDistance_ = positionDist(currentX, currentY, endX, endY) + queuedPathLength_;
+
+            // Project the robot on the current segment, then look ahead along it.
+            float segmentX = endX - segmentStartX_;
+            float segmentY = endY - segmentStartY_;
+            float segmentLength = sqrt(segmentX * segmentX + segmentY * segmentY);
+            float progress = 1;
+            if (segmentLength > 0) {
+                float projection = ((currentX - segmentStartX_) * segmentX + (currentY - segmentStartY_) * segmentY) / segmentLength;
+                progress = (constrain(projection, 0, segmentLength) + lookaheadDistance_) / segmentLength;
+            }
+
+            if (progress >= 1) {
+                setTarget(endX, endY);
+                pursuingPath_ = waypoints_.count() > 1;
+            } else {
+                setTarget(segmentStartX_ + segmentX * progress, segmentStartY_ + segmentY * progress);
+                pursuingPath_ = true;
+            }
+        }
+
+        bool following_;
+        float targetX_;
+        float targetY_;
+        float velocity_;                // Velocity at which the robot follows a target
+        float angularVelocityScale_;    // Scale factor for angular velocity when following a target
+        float curveTightness_;          // Tightness of the curve when following a target
+        SpeedCurve speedCurve_;         // Speed factor against the heading error for curveTightness_
+        MotionProfile<Scalar> profile_;
+        bool inverted_;
+        WaypointQueue waypoints_;       // Waypoints left to reach
+        float segmentStartX_;           // Start of the path segment leading to the first waypoint
+        float segmentStartY_;
+        uint16_t completedWaypoints_;   // Waypoints reached since the last clearWaypoints()
+        float lookaheadDistance_;       // Distance ahead of the robot that the waypoint follower aims at
+        bool pursuingPath_;             // Whether the target is a lookahead point rather than the end of the path
+        float queuedPathLength_;        // Length of the path between the queued waypoints
+        float pathRemainingDistance_;   // Distance along the path from the robot to the last waypoint
+    };
+}
+
+#endif // FOLLOWER_H
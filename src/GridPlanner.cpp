@@ -0,0 +1,258 @@
+#include "GridPlanner.h"
+
+#define PLANNER_SCALE (OCCUPANCY_GRID_SIZE / PLANNER_GRID_SIZE)
+#define PLANNER_COST_MASK 0x0FFF
+#define PLANNER_UNSEEN 0x0FFF
+#define PLANNER_CLOSED 0x8000
+
+namespace RobusPosition
+{
+    namespace {
+        // Neighbour offsets, counterclockwise from +X; odd directions are diagonal.
+        const int8_t DIRECTION_X[8] PROGMEM = {1, 1, 0, -1, -1, -1, 0, 1};
+        const int8_t DIRECTION_Y[8] PROGMEM = {0, 1, 1, 1, 0, -1, -1, -1};
+
+        inline uint16_t costOf(uint16_t node) { return node & PLANNER_COST_MASK; }
+        inline uint8_t directionOf(uint16_t node) { return (node >> 12) & 7; }
+    }
+
+    void GridPlanner::placeOn(const OccupancyGrid &grid) {
+        originX_ = grid.getOriginX();
+        originY_ = grid.getOriginY();
+        cellSize_ = grid.getCellSize() * PLANNER_SCALE;
+    }
+
+    int16_t GridPlanner::toCell(float coordinate, float origin, float cellSize) {
+        float cell = floor((coordinate - origin) / cellSize);
+        return (int16_t) constrain(cell, -4096, 4096);
+    }
+
+    bool GridPlanner::isCellBlocked(const OccupancyGrid &grid, int16_t cellX, int16_t cellY) const {
+        int16_t firstX = cellX * PLANNER_SCALE - PLANNER_INFLATION;
+        int16_t firstY = cellY * PLANNER_SCALE - PLANNER_INFLATION;
+        for (int16_t y = firstY; y < firstY + PLANNER_SCALE + 2 * PLANNER_INFLATION; y++) {
+            for (int16_t x = firstX; x < firstX + PLANNER_SCALE + 2 * PLANNER_INFLATION; x++) {
+                if (grid.getCell(x, y) >= CELL_LIKELY) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void GridPlanner::buildBlocked(const OccupancyGrid &grid) {
+        memset(blocked_, 0, sizeof(blocked_));
+        // Spread each obstacle over the planner cells it inflates, one pass over the grid.
+        for (int16_t y = 0; y < OCCUPANCY_GRID_SIZE; y++) {
+            for (int16_t x = 0; x < OCCUPANCY_GRID_SIZE; x++) {
+                if (grid.getCell(x, y) < CELL_LIKELY) {
+                    continue;
+                }
+                int16_t firstX = constrain(x - PLANNER_INFLATION, 0, OCCUPANCY_GRID_SIZE - 1) / PLANNER_SCALE;
+                int16_t firstY = constrain(y - PLANNER_INFLATION, 0, OCCUPANCY_GRID_SIZE - 1) / PLANNER_SCALE;
+                int16_t lastX = constrain(x + PLANNER_INFLATION, 0, OCCUPANCY_GRID_SIZE - 1) / PLANNER_SCALE;
+                int16_t lastY = constrain(y + PLANNER_INFLATION, 0, OCCUPANCY_GRID_SIZE - 1) / PLANNER_SCALE;
+                for (int16_t cellY = firstY; cellY <= lastY; cellY++) {
+                    for (int16_t cellX = firstX; cellX <= lastX; cellX++) {
+                        uint16_t index = cellY * PLANNER_GRID_SIZE + cellX;
+                        blocked_[index >> 3] |= 1 << (index & 7);
+                    }
+                }
+            }
+        }
+    }
+
+    bool GridPlanner::isBlocked(int16_t cellX, int16_t cellY) const {
+        uint16_t index = cellY * PLANNER_GRID_SIZE + cellX;
+        return blocked_[index >> 3] & (1 << (index & 7));
+    }
+
+    uint16_t GridPlanner::heuristic(uint16_t node, uint16_t goal) const {
+        // Octile distance with the straight and diagonal costs of the search, 2 and 3.
+        uint8_t dx = abs((int16_t) (node % PLANNER_GRID_SIZE) - (int16_t) (goal % PLANNER_GRID_SIZE));
+        uint8_t dy = abs((int16_t) (node / PLANNER_GRID_SIZE) - (int16_t) (goal / PLANNER_GRID_SIZE));
+        return 2 * (dx + dy) - (dx < dy ? dx : dy);
+    }
+
+    bool GridPlanner::push(uint16_t node, uint16_t cost) {
+        if (openCount_ >= PLANNER_OPEN_SIZE) {
+            return false;
+        }
+        uint8_t i = openCount_++;
+        while (i > 0) {
+            uint8_t parent = (i - 1) / 2;
+            if (open_[parent].cost <= cost) {
+                break;
+            }
+            open_[i] = open_[parent];
+            i = parent;
+        }
+        open_[i].node = node;
+        open_[i].cost = cost;
+        return true;
+    }
+
+    uint16_t GridPlanner::pop() {
+        uint16_t node = open_[0].node;
+        OpenEntry last = open_[--openCount_];
+        uint8_t i = 0;
+        while (true) {
+            uint16_t child = 2 * i + 1;
+            if (child >= openCount_) {
+                break;
+            }
+            if (child + 1 < openCount_ && open_[child + 1].cost < open_[child].cost) {
+                child++;
+            }
+            if (last.cost <= open_[child].cost) {
+                break;
+            }
+            open_[i] = open_[child];
+            i = child;
+        }
+        open_[i] = last;
+        return node;
+    }
+
+    PlanResult GridPlanner::plan(const OccupancyGrid &grid, float startX, float startY, float goalX, float goalY) {
+        pathLength_ = 0;
+        placeOn(grid);
+        int16_t startCellX = toCell(startX, originX_, cellSize_);
+        int16_t startCellY = toCell(startY, originY_, cellSize_);
+        int16_t goalCellX = toCell(goalX, originX_, cellSize_);
+        int16_t goalCellY = toCell(goalY, originY_, cellSize_);
+        if (startCellX < 0 || startCellX >= PLANNER_GRID_SIZE || startCellY < 0 || startCellY >= PLANNER_GRID_SIZE ||
+            goalCellX < 0 || goalCellX >= PLANNER_GRID_SIZE || goalCellY < 0 || goalCellY >= PLANNER_GRID_SIZE) {
+            return PLAN_OUTSIDE;
+        }
+
+        buildBlocked(grid);
+        if (isBlocked(goalCellX, goalCellY)) {
+            return PLAN_GOAL_BLOCKED;
+        }
+
+        for (uint16_t i = 0; i < PLANNER_GRID_SIZE * PLANNER_GRID_SIZE; i++) {
+            nodes_[i] = PLANNER_UNSEEN;
+        }
+        uint16_t start = startCellY * PLANNER_GRID_SIZE + startCellX;
+        uint16_t goal = goalCellY * PLANNER_GRID_SIZE + goalCellX;
+        nodes_[start] = 0;
+        openCount_ = 0;
+        push(start, heuristic(start, goal));
+
+        // The start may lie in the inflation of an obstacle, the robot is still allowed to leave it.
+        bool found = false;
+        while (openCount_ > 0) {
+            uint16_t node = pop();
+            if (nodes_[node] & PLANNER_CLOSED) {
+                continue; // Stale entry, the cell was reached again with a lower cost.
+            }
+            nodes_[node] |= PLANNER_CLOSED;
+            if (node == goal) {
+                found = true;
+                break;
+            }
+
+            int16_t cellX = node % PLANNER_GRID_SIZE;
+            int16_t cellY = node / PLANNER_GRID_SIZE;
+            for (uint8_t direction = 0; direction < 8; direction++) {
+                int8_t stepX = pgm_read_byte(&DIRECTION_X[direction]);
+                int8_t stepY = pgm_read_byte(&DIRECTION_Y[direction]);
+                int16_t nextX = cellX + stepX;
+                int16_t nextY = cellY + stepY;
+                if (nextX < 0 || nextX >= PLANNER_GRID_SIZE || nextY < 0 || nextY >= PLANNER_GRID_SIZE ||
+                    isBlocked(nextX, nextY)) {
+                    continue;
+                }
+                bool diagonal = direction & 1;
+                if (diagonal && (isBlocked(nextX, cellY) || isBlocked(cellX, nextY))) {
+                    continue; // No corner cutting.
+                }
+
+                uint16_t next = nextY * PLANNER_GRID_SIZE + nextX;
+                uint16_t cost = costOf(nodes_[node]) + (diagonal ? 3 : 2);
+                if ((nodes_[next] & PLANNER_CLOSED) || cost >= costOf(nodes_[next])) {
+                    continue;
+                }
+                nodes_[next] = cost | ((uint16_t) direction << 12);
+                if (!push(next, cost + heuristic(next, goal))) {
+                    return PLAN_OPEN_SET_FULL;
+                }
+            }
+        }
+        if (!found) {
+            return PLAN_NO_PATH;
+        }
+
+        // Walk back from the goal, keeping the cells where the direction changes.
+        uint8_t count = 0;
+        uint16_t node = goal;
+        uint8_t direction = directionOf(nodes_[goal]);
+        path_[count++] = goal;
+        while (node != start) {
+            uint8_t arrival = directionOf(nodes_[node]);
+            if (arrival != direction) {
+                if (count >= PLANNER_PATH_SIZE) {
+                    return PLAN_TOO_LONG;
+                }
+                path_[count++] = node;
+                direction = arrival;
+            }
+            int8_t stepX = pgm_read_byte(&DIRECTION_X[arrival]);
+            int8_t stepY = pgm_read_byte(&DIRECTION_Y[arrival]);
+            node -= stepY * PLANNER_GRID_SIZE + stepX;
+        }
+
+        for (uint8_t i = 0; i < count / 2; i++) {
+            uint16_t swapped = path_[i];
+            path_[i] = path_[count - 1 - i];
+            path_[count - 1 - i] = swapped;
+        }
+        pathLength_ = count;
+        goalX_ = goalX;
+        goalY_ = goalY;
+        return PLAN_FOUND;
+    }
+
+    void GridPlanner::getPathPoint(uint8_t i, float &x, float &y) const {
+        if (i + 1 >= pathLength_) {
+            x = goalX_;
+            y = goalY_;
+            return;
+        }
+        x = originX_ + (path_[i] % PLANNER_GRID_SIZE + 0.5f) * cellSize_;
+        y = originY_ + (path_[i] / PLANNER_GRID_SIZE + 0.5f) * cellSize_;
+    }
+
+    bool GridPlanner::isSegmentBlocked(const OccupancyGrid &grid, float x0, float y0, float x1, float y1) const {
+        int16_t cellX = toCell(x0, originX_, cellSize_);
+        int16_t cellY = toCell(y0, originY_, cellSize_);
+        int16_t endX = toCell(x1, originX_, cellSize_);
+        int16_t endY = toCell(y1, originY_, cellSize_);
+
+        // Bresenham over the planner cells, checking each one directly on the grid.
+        int16_t dx = abs(endX - cellX);
+        int16_t dy = -abs(endY - cellY);
+        int8_t stepX = cellX < endX ? 1 : -1;
+        int8_t stepY = cellY < endY ? 1 : -1;
+        int16_t error = dx + dy;
+        while (cellX != endX || cellY != endY) {
+            int16_t doubled = 2 * error;
+            if (doubled >= dy) {
+                error += dy;
+                cellX += stepX;
+            }
+            if (doubled <= dx) {
+                error += dx;
+                cellY += stepY;
+            }
+            if (cellX < 0 || cellX >= PLANNER_GRID_SIZE || cellY < 0 || cellY >= PLANNER_GRID_SIZE) {
+                continue;
+            }
+            if (!isBlocked(cellX, cellY) && isCellBlocked(grid, cellX, cellY)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
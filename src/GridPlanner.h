@@ -0,0 +1,112 @@
+#ifndef GRID_PLANNER_H
+#define GRID_PLANNER_H
+
+#include <Arduino.h>
+#include "OccupancyGrid.h"
+#include "WaypointQueue.h"
+
+#ifndef PLANNER_GRID_SIZE
+#define PLANNER_GRID_SIZE 32 // Cells per side, OCCUPANCY_GRID_SIZE divided by a power of 2
+#endif
+
+#ifndef PLANNER_OPEN_SIZE
+#define PLANNER_OPEN_SIZE 128
+#endif
+
+#ifndef PLANNER_INFLATION
+#define PLANNER_INFLATION 2 // Occupancy cells kept clear around obstacles for the robot body
+#endif
+
+#define PLANNER_PATH_SIZE WAYPOINT_QUEUE_SIZE
+
+namespace RobusPosition
+{
+    /**
+     * @brief Outcome of GridPlanner::plan().
+     */
+    enum PlanResult {
+        PLAN_FOUND,         /**< The path is ready. */
+        PLAN_NO_PATH,       /**< The obstacles separate the start from the goal. */
+        PLAN_OUTSIDE,       /**< The start or the goal is outside the grid. */
+        PLAN_GOAL_BLOCKED,  /**< The goal is on an obstacle or too close to one. */
+        PLAN_OPEN_SET_FULL, /**< The search needed more than PLANNER_OPEN_SIZE open cells. */
+        PLAN_TOO_LONG       /**< The path has more than PLANNER_PATH_SIZE turns. */
+    };
+
+    /**
+     * @brief A* path planner over a downsampled occupancy grid, without heap allocation.
+     *
+     * Each planner cell covers OCCUPANCY_GRID_SIZE / PLANNER_GRID_SIZE occupancy cells per side and
+     * is blocked when an obstacle lies within PLANNER_INFLATION occupancy cells of it. The search is
+     * 8-connected with costs 2 and 3 and does not cut corners. The path is reduced to the cells where
+     * its direction changes, ready for the waypoint follower.
+     *
+     * With the default sizes it takes about 2.7 KB of SRAM, 2 KB of them for the node costs, on top
+     * of the 1 KB occupancy grid out of the 8 KB of the Mega. The planner has no constructor, so the
+     * linker drops it from sketches that never plan. The grid, the pose history and the pose filter
+     * are constructed at startup and always take their SRAM: with the rest of the state of
+     * RobusPosition, about 2.4 KB. Build with ROBUS_POSITION_NO_MAP to remove the grid and the planner.
+     */
+    class GridPlanner
+    {
+      public:
+        /**
+         * @brief Plan a path on the obstacles of an occupancy grid.
+         * @param grid The occupancy grid.
+         * @param startX The X-coordinate of the start, usually the robot.
+         * @param startY The Y-coordinate of the start.
+         * @param goalX The X-coordinate of the goal.
+         * @param goalY The Y-coordinate of the goal.
+         * @return PLAN_FOUND if a path was found.
+         */
+        PlanResult plan(const OccupancyGrid &grid, float startX, float startY, float goalX, float goalY);
+
+        /**
+         * @brief Get the number of points of the last path found, the start excluded.
+         */
+        uint8_t getPathLength() const { return pathLength_; }
+
+        /**
+         * @brief Get a point of the last path found; the last one is the goal itself.
+         * @param i The index of the point, from the start.
+         */
+        void getPathPoint(uint8_t i, float &x, float &y) const;
+
+        /**
+         * @brief Check if a straight segment crosses an obstacle added to the grid since the last plan().
+         *
+         * Cells that were already blocked when planning are ignored: the path only crosses them to
+         * leave the start, and a new search would find the same path.
+         */
+        bool isSegmentBlocked(const OccupancyGrid &grid, float x0, float y0, float x1, float y1) const;
+
+      private:
+        struct OpenEntry {
+            uint16_t node;
+            uint16_t cost; // Cost so far plus heuristic
+        };
+
+        void placeOn(const OccupancyGrid &grid);
+        static int16_t toCell(float coordinate, float origin, float cellSize);
+        bool isCellBlocked(const OccupancyGrid &grid, int16_t cellX, int16_t cellY) const;
+        void buildBlocked(const OccupancyGrid &grid);
+        bool isBlocked(int16_t cellX, int16_t cellY) const;
+        uint16_t heuristic(uint16_t node, uint16_t goal) const;
+        bool push(uint16_t node, uint16_t cost);
+        uint16_t pop();
+
+        uint16_t nodes_[PLANNER_GRID_SIZE * PLANNER_GRID_SIZE]; // Cost so far (12 bits), parent direction (3 bits), closed (1 bit)
+        uint8_t blocked_[PLANNER_GRID_SIZE * PLANNER_GRID_SIZE / 8];
+        OpenEntry open_[PLANNER_OPEN_SIZE]; // Binary heap on the cost
+        uint8_t openCount_;
+        uint16_t path_[PLANNER_PATH_SIZE];
+        uint8_t pathLength_;
+        float goalX_;
+        float goalY_;
+        float originX_;
+        float originY_;
+        float cellSize_;
+    };
+}
+
+#endif // GRID_PLANNER_H
@@ -0,0 +1,122 @@
+#ifndef INTEGRATION_H
+#define INTEGRATION_H
+
+#include <Arduino.h>
+#include "FastMath.h"
+
+#ifndef INTEGRATION_ITERATION
+#define INTEGRATION_ITERATION 1
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Method used to integrate the robot displacement over one update.
+     */
+    enum Integrator {
+        EULER,      /**< INTEGRATION_ITERATION explicit Euler sub-steps. */
+        MIDPOINT,   /**< One step at the mean heading of the interval. */
+        RK4,        /**< Fourth order Runge-Kutta. */
+        ARC,        /**< Exact constant-curvature arc. */
+        SELECTED    /**< Odometry template parameter: the integrator is chosen at run time. */
+    };
+
+    /**
+     * @brief Cosine used by the odometry, FastMath::fastCos() for float with ROBUS_POSITION_FAST_MATH.
+     */
+    template<typename Scalar>
+    inline Scalar positionCos(Scalar angle) {
+        return cos(angle);
+    }
+
+    /**
+     * @brief Sine used by the odometry, FastMath::fastSin() for float with ROBUS_POSITION_FAST_MATH.
+     */
+    template<typename Scalar>
+    inline Scalar positionSin(Scalar angle) {
+        return sin(angle);
+    }
+
+#ifdef ROBUS_POSITION_FAST_MATH
+    template<>
+    inline float positionCos<float>(float angle) {
+        return FastMath::fastCos(angle);
+    }
+
+    template<>
+    inline float positionSin<float>(float angle) {
+        return FastMath::fastSin(angle);
+    }
+#endif
+
+    /**
+     * @brief Compute sin(angle) / angle without dividing by zero.
+     * @param angle The angle in radians.
+     * @return sin(angle) / angle, with sinc(0) = 1.
+     */
+    template<typename Scalar>
+    Scalar sinc(Scalar angle) {
+        Scalar magnitude = angle < Scalar(0) ? -angle : angle;
+        if (magnitude < Scalar(0.05f)) {
+            // Taylor series, the next term is below 6e-8 in this range.
+            return Scalar(1) - angle * angle / 6;
+        }
+        // Keeps the exact sine, the absolute error of a table divided by a small angle would be too large.
+        return sin(angle) / angle;
+    }
+
+    /**
+     * @brief Move a position along a path of constant velocity and angular velocity.
+     *
+     * Works with float as well as FixedPoint::Fixed.
+     *
+     * @param integrator The integration method.
+     * @param x The X-coordinate, updated in place.
+     * @param y The Y-coordinate, updated in place.
+     * @param orientation The orientation at the start of the interval, in radians.
+     * @param distance The distance travelled during the interval.
+     * @param rotation The change of orientation during the interval, in radians.
+     */
+    template<typename Scalar>
+    void integrate(Integrator integrator, Scalar &x, Scalar &y, Scalar orientation, Scalar distance, Scalar rotation) {
+        switch (integrator) {
+            case MIDPOINT: {
+                Scalar heading = orientation + rotation / 2;
+                x += positionCos(heading) * distance;
+                y += positionSin(heading) * distance;
+                break;
+            }
+            case RK4: {
+                // The derivative only depends on the heading, so RK4 reduces to Simpson's rule.
+                Scalar middle = orientation + rotation / 2;
+                Scalar end = orientation + rotation;
+                // Divide once at the end, distance / 6 alone would lose most of its low bits in fixed point.
+                x += (positionCos(orientation) + Scalar(4) * positionCos(middle) + positionCos(end)) * distance / 6;
+                y += (positionSin(orientation) + Scalar(4) * positionSin(middle) + positionSin(end)) * distance / 6;
+                break;
+            }
+            case ARC: {
+                // Chord of the arc: its length is distance * sinc(rotation / 2), its direction the mean heading.
+                Scalar halfRotation = rotation / 2;
+                Scalar chord = distance * sinc(halfRotation);
+                Scalar heading = orientation + halfRotation;
+                x += positionCos(heading) * chord;
+                y += positionSin(heading) * chord;
+                break;
+            }
+            case EULER:
+            default: {
+                Scalar iterationDistance = distance / INTEGRATION_ITERATION;
+                Scalar iterationRotation = rotation / INTEGRATION_ITERATION;
+                for (int i = 0; i < INTEGRATION_ITERATION; i++) {
+                    x += positionCos(orientation) * iterationDistance;
+                    y += positionSin(orientation) * iterationDistance;
+                    orientation += iterationRotation;
+                }
+                break;
+            }
+        }
+    }
+}
+
+#endif // INTEGRATION_H
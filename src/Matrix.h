@@ -0,0 +1,114 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <Arduino.h>
+
+namespace RobusPosition
+{
+    /**
+     * @brief Fixed-size matrix stored inline, without heap allocation.
+     *
+     * The dimensions are template parameters, so mismatched products do not compile and
+     * the loops unroll for the small sizes used by the pose filter.
+     */
+    template<uint8_t Rows, uint8_t Cols, typename Scalar = float>
+    struct Matrix {
+        Matrix() {
+            fill(Scalar(0));
+        }
+
+        /**
+         * @brief Build the identity matrix.
+         * @return A matrix with ones on the diagonal and zeros elsewhere.
+         */
+        static Matrix identity() {
+            Matrix result;
+            for (uint8_t i = 0; i < Rows && i < Cols; i++) {
+                result.data[i][i] = Scalar(1);
+            }
+            return result;
+        }
+
+        void fill(Scalar value) {
+            for (uint8_t i = 0; i < Rows; i++) {
+                for (uint8_t j = 0; j < Cols; j++) {
+                    data[i][j] = value;
+                }
+            }
+        }
+
+        Scalar &operator()(uint8_t row, uint8_t col) { return data[row][col]; }
+        Scalar operator()(uint8_t row, uint8_t col) const { return data[row][col]; }
+
+        Matrix<Cols, Rows, Scalar> transpose() const {
+            Matrix<Cols, Rows, Scalar> result;
+            for (uint8_t i = 0; i < Rows; i++) {
+                for (uint8_t j = 0; j < Cols; j++) {
+                    result.data[j][i] = data[i][j];
+                }
+            }
+            return result;
+        }
+
+        Matrix &operator+=(const Matrix &other) {
+            for (uint8_t i = 0; i < Rows; i++) {
+                for (uint8_t j = 0; j < Cols; j++) {
+                    data[i][j] += other.data[i][j];
+                }
+            }
+            return *this;
+        }
+
+        Matrix &operator-=(const Matrix &other) {
+            for (uint8_t i = 0; i < Rows; i++) {
+                for (uint8_t j = 0; j < Cols; j++) {
+                    data[i][j] -= other.data[i][j];
+                }
+            }
+            return *this;
+        }
+
+        Matrix &operator*=(Scalar factor) {
+            for (uint8_t i = 0; i < Rows; i++) {
+                for (uint8_t j = 0; j < Cols; j++) {
+                    data[i][j] *= factor;
+                }
+            }
+            return *this;
+        }
+
+        Scalar data[Rows][Cols];
+    };
+
+    template<uint8_t Rows, uint8_t Cols, typename Scalar>
+    Matrix<Rows, Cols, Scalar> operator+(Matrix<Rows, Cols, Scalar> a, const Matrix<Rows, Cols, Scalar> &b) {
+        return a += b;
+    }
+
+    template<uint8_t Rows, uint8_t Cols, typename Scalar>
+    Matrix<Rows, Cols, Scalar> operator-(Matrix<Rows, Cols, Scalar> a, const Matrix<Rows, Cols, Scalar> &b) {
+        return a -= b;
+    }
+
+    template<uint8_t Rows, uint8_t Cols, typename Scalar>
+    Matrix<Rows, Cols, Scalar> operator*(Matrix<Rows, Cols, Scalar> a, Scalar factor) {
+        return a *= factor;
+    }
+
+    template<uint8_t Rows, uint8_t Inner, uint8_t Cols, typename Scalar>
+    Matrix<Rows, Cols, Scalar> operator*(const Matrix<Rows, Inner, Scalar> &a, const Matrix<Inner, Cols, Scalar> &b) {
+        Matrix<Rows, Cols, Scalar> result;
+        for (uint8_t i = 0; i < Rows; i++) {
+            for (uint8_t j = 0; j < Cols; j++) {
+                Scalar sum = Scalar(0);
+                for (uint8_t k = 0; k < Inner; k++) {
+                    sum += a.data[i][k] * b.data[k][j];
+                }
+                result.data[i][j] = sum;
+            }
+        }
+        return result;
+    }
+}
+
+#endif // MATRIX_H
@@ -0,0 +1,154 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <Arduino.h>
+
+namespace RobusPosition
+{
+    /**
+     * @brief Incremental trapezoidal or jerk-limited velocity profile.
+     *
+     * Each update moves the velocity toward the requested one within the acceleration, deceleration
+     * and jerk limits, and caps it so the robot can still brake before the end of the remaining distance.
+     * A limit of zero disables it. Works with float as well as FixedPoint::Fixed.
+     */
+    template<typename Scalar>
+    class MotionProfile
+    {
+      public:
+        MotionProfile() : acceleration_(0), deceleration_(0), jerk_(0), velocity_(0), currentAcceleration_(0) {}
+
+        /**
+         * @brief Compute the velocity for this update.
+         * @param desired The velocity requested by the controller.
+         * @param remaining The distance left before the robot must be stopped, negative if unknown.
+         * @param dt Elapsed time since the last update, in seconds.
+         * @return The limited velocity.
+         */
+        Scalar update(Scalar desired, Scalar remaining, Scalar dt) {
+            if (!(dt > Scalar(0))) {
+                return velocity_;
+            }
+
+            // Highest speed from which the deceleration can still stop the robot in the remaining distance.
+            bool braking = false;
+            if (deceleration_ > Scalar(0) && remaining >= Scalar(0)) {
+                // Braking one update late costs v * d * dt / 2 and ramping the deceleration up and down at the jerk
+                // limit v * d / 2j, so the speed must keep v^2 / 2d + v * ramp / 2d within the remaining distance.
+                Scalar ramp = deceleration_ * dt;
+                Scalar gain = Scalar(0);
+                if (jerk_ > Scalar(0)) {
+                    ramp += deceleration_ * deceleration_ / jerk_;
+                    // A speed-up keeps going while its acceleration eases back to zero, brake from where it ends.
+                    Scalar speed = velocity_ < Scalar(0) ? -velocity_ : velocity_;
+                    Scalar push = velocity_ < Scalar(0) ? -currentAcceleration_ : currentAcceleration_;
+                    if (push > Scalar(0)) {
+                        Scalar easeTime = push / jerk_;
+                        gain = push * easeTime / 2;
+                        remaining -= (speed + push * easeTime / 3) * easeTime;
+                        if (remaining < Scalar(0)) {
+                            remaining = Scalar(0);
+                        }
+                    }
+                }
+                // Solved for v as 4 d r / (sqrt(ramp^2 + 8 d r) + ramp), which stays exactly zero at the end in fixed point.
+                Scalar brake = Scalar(0);
+                if (remaining > Scalar(0)) {
+                    Scalar reach = Scalar(4) * deceleration_ * remaining;
+                    brake = reach / (sqrt(ramp * ramp + Scalar(2) * reach) + ramp) - gain;
+                    if (brake < Scalar(0)) {
+                        brake = Scalar(0);
+                    }
+                }
+                if (desired >= brake) {
+                    desired = brake;
+                    braking = true;
+                } else if (desired <= -brake) {
+                    desired = -brake;
+                    braking = true;
+                }
+            }
+
+            Scalar change = desired - velocity_;
+            bool speedingUp = (velocity_ >= Scalar(0)) == (change >= Scalar(0));
+            Scalar limit = speedingUp ? acceleration_ : deceleration_;
+
+            Scalar magnitude = change < Scalar(0) ? -change : change;
+            Scalar wanted = magnitude / dt;
+            if (limit > Scalar(0) && wanted > limit) {
+                wanted = limit;
+            }
+            if (jerk_ > Scalar(0)) {
+                // Ease out so the acceleration is back to zero when the velocity is reached. Stepping it
+                // down by jerk * dt each update gains a^2 / 2j + a * dt / 2, solved for a.
+                // Slowing down on the brake cap, the velocity to reach is zero rather than the cap itself.
+                Scalar halfStep = jerk_ * dt / 2;
+                Scalar ease = braking && !speedingUp ? (velocity_ < Scalar(0) ? -velocity_ : velocity_) : magnitude;
+                Scalar easing = sqrt(halfStep * halfStep + Scalar(2) * jerk_ * ease) - halfStep;
+                if (wanted > easing) {
+                    wanted = easing;
+                }
+            }
+            if (change < Scalar(0)) {
+                wanted = -wanted;
+            }
+
+            Scalar step = jerk_ * dt;
+            Scalar previous = currentAcceleration_;
+            if (jerk_ > Scalar(0)) {
+                currentAcceleration_ = constrain(wanted, currentAcceleration_ - step, currentAcceleration_ + step);
+            } else {
+                currentAcceleration_ = wanted;
+            }
+
+            Scalar next = velocity_ + currentAcceleration_ * dt;
+            if ((change >= Scalar(0) && next > desired) || (change < Scalar(0) && next < desired)) {
+                // Settle on the velocity, unless the desired one moved faster than the jerk allows to
+                // bring the acceleration back to zero: pass it and come back on the next updates.
+                if (!(jerk_ > Scalar(0)) || (previous <= step && previous >= -step)) {
+                    next = desired;
+                    currentAcceleration_ = Scalar(0);
+                }
+            }
+            velocity_ = next;
+            return velocity_;
+        }
+
+        /**
+         * @brief Restart the profile from a given velocity, with no acceleration.
+         * @param velocity The current velocity.
+         */
+        void reset(Scalar velocity = Scalar(0)) {
+            velocity_ = velocity;
+            currentAcceleration_ = Scalar(0);
+        }
+
+        /**
+         * @brief Set the limits of the profile, zero disables a limit.
+         * @param acceleration Maximum acceleration when speeding up.
+         * @param deceleration Maximum deceleration when slowing down, also used to brake before the target.
+         * @param jerk Maximum change of acceleration per second.
+         */
+        void setLimits(Scalar acceleration, Scalar deceleration, Scalar jerk) {
+            acceleration_ = acceleration;
+            deceleration_ = deceleration;
+            jerk_ = jerk;
+        }
+
+        Scalar getAcceleration() const { return acceleration_; }
+        Scalar getDeceleration() const { return deceleration_; }
+        Scalar getJerk() const { return jerk_; }
+
+        Scalar getVelocity() const { return velocity_; }
+        Scalar getCurrentAcceleration() const { return currentAcceleration_; }
+
+      private:
+        Scalar acceleration_;
+        Scalar deceleration_;
+        Scalar jerk_;
+        Scalar velocity_;
+        Scalar currentAcceleration_;
+    };
+}
+
+#endif // MOTION_PROFILE_H
@@ -0,0 +1,106 @@
+#include "OccupancyGrid.h"
+
+namespace RobusPosition
+{
+    OccupancyGrid::OccupancyGrid() {
+        // 64 cells of 5 cm centered on the start position.
+        setGeometry(-OCCUPANCY_GRID_SIZE * 0.025f, -OCCUPANCY_GRID_SIZE * 0.025f, 0.05f);
+    }
+
+    void OccupancyGrid::setGeometry(float originX, float originY, float cellSize) {
+        originX_ = originX;
+        originY_ = originY;
+        cellSize_ = cellSize;
+        clear();
+    }
+
+    void OccupancyGrid::clear() {
+        // 0b01010101, every cell CELL_UNKNOWN.
+        memset(cells_, 0x55, sizeof(cells_));
+    }
+
+    int16_t OccupancyGrid::toCell(float coordinate, float origin) const {
+        float cell = floor((coordinate - origin) / cellSize_);
+        // Far outside the grid, keep the ray tracing in 16 bits.
+        return (int16_t) constrain(cell, -4096, 4096);
+    }
+
+    bool OccupancyGrid::worldToCell(float x, float y, int16_t &cellX, int16_t &cellY) const {
+        cellX = toCell(x, originX_);
+        cellY = toCell(y, originY_);
+        return cellX >= 0 && cellX < OCCUPANCY_GRID_SIZE && cellY >= 0 && cellY < OCCUPANCY_GRID_SIZE;
+    }
+
+    void OccupancyGrid::cellToWorld(int16_t cellX, int16_t cellY, float &x, float &y) const {
+        x = originX_ + (cellX + 0.5f) * cellSize_;
+        y = originY_ + (cellY + 0.5f) * cellSize_;
+    }
+
+    CellState OccupancyGrid::getCell(int16_t cellX, int16_t cellY) const {
+        if (cellX < 0 || cellX >= OCCUPANCY_GRID_SIZE || cellY < 0 || cellY >= OCCUPANCY_GRID_SIZE) {
+            return CELL_UNKNOWN;
+        }
+        uint16_t index = (uint16_t) cellY * OCCUPANCY_GRID_SIZE + cellX;
+        return (CellState) ((cells_[index >> 2] >> ((index & 3) * 2)) & 3);
+    }
+
+    void OccupancyGrid::setCell(int16_t cellX, int16_t cellY, CellState state) {
+        if (cellX < 0 || cellX >= OCCUPANCY_GRID_SIZE || cellY < 0 || cellY >= OCCUPANCY_GRID_SIZE) {
+            return;
+        }
+        uint16_t index = (uint16_t) cellY * OCCUPANCY_GRID_SIZE + cellX;
+        uint8_t shift = (index & 3) * 2;
+        cells_[index >> 2] = (cells_[index >> 2] & ~(3 << shift)) | (state << shift);
+    }
+
+    CellState OccupancyGrid::getCellAt(float x, float y) const {
+        int16_t cellX, cellY;
+        worldToCell(x, y, cellX, cellY);
+        return getCell(cellX, cellY);
+    }
+
+    void OccupancyGrid::markOccupied(float x, float y) {
+        int16_t cellX, cellY;
+        worldToCell(x, y, cellX, cellY);
+        setCell(cellX, cellY, CELL_OCCUPIED);
+    }
+
+    void OccupancyGrid::observe(int16_t cellX, int16_t cellY, bool hit) {
+        if (cellX < 0 || cellX >= OCCUPANCY_GRID_SIZE || cellY < 0 || cellY >= OCCUPANCY_GRID_SIZE) {
+            return;
+        }
+        uint8_t state = getCell(cellX, cellY);
+        if (hit && state < CELL_OCCUPIED) {
+            setCell(cellX, cellY, (CellState) (state + 1));
+        } else if (!hit && state > CELL_FREE) {
+            setCell(cellX, cellY, (CellState) (state - 1));
+        }
+    }
+
+    void OccupancyGrid::insertRay(float x0, float y0, float x1, float y1, bool hit) {
+        int16_t cellX = toCell(x0, originX_);
+        int16_t cellY = toCell(y0, originY_);
+        int16_t endX = toCell(x1, originX_);
+        int16_t endY = toCell(y1, originY_);
+
+        // Bresenham over the cells from the sensor to the end of the beam, the end excluded.
+        int16_t dx = abs(endX - cellX);
+        int16_t dy = -abs(endY - cellY);
+        int8_t stepX = cellX < endX ? 1 : -1;
+        int8_t stepY = cellY < endY ? 1 : -1;
+        int16_t error = dx + dy;
+        while (cellX != endX || cellY != endY) {
+            observe(cellX, cellY, false);
+            int16_t doubled = 2 * error;
+            if (doubled >= dy) {
+                error += dy;
+                cellX += stepX;
+            }
+            if (doubled <= dx) {
+                error += dx;
+                cellY += stepY;
+            }
+        }
+        observe(endX, endY, hit);
+    }
+}
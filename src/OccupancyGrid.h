@@ -0,0 +1,98 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <Arduino.h>
+
+#ifndef OCCUPANCY_GRID_SIZE
+#define OCCUPANCY_GRID_SIZE 64 // Cells per side, a multiple of 4
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief State of a cell, a 2-bit saturating counter of the hits minus the misses.
+     */
+    enum CellState {
+        CELL_FREE,      /**< Seen empty more often than hit. */
+        CELL_UNKNOWN,   /**< Never seen, or seen as often empty as hit. */
+        CELL_LIKELY,    /**< Hit once more than seen empty. */
+        CELL_OCCUPIED   /**< Hit at least twice more than seen empty. */
+    };
+
+    /**
+     * @brief Square occupancy grid in world coordinates, with 2 bits per cell.
+     *
+     * The default 64x64 cells take 1 KB of SRAM. Range measures are inserted with integer
+     * Bresenham ray tracing: every cell crossed by the beam moves toward CELL_FREE, the cell of
+     * the echo moves toward CELL_OCCUPIED. Cells outside the grid read as CELL_UNKNOWN.
+     */
+    class OccupancyGrid
+    {
+      public:
+        OccupancyGrid();
+
+        /**
+         * @brief Place the grid in the world and clear it.
+         * @param originX The X-coordinate of the corner of cell (0, 0).
+         * @param originY The Y-coordinate of the corner of cell (0, 0).
+         * @param cellSize The side of a cell.
+         */
+        void setGeometry(float originX, float originY, float cellSize);
+
+        /**
+         * @brief Set all the cells to CELL_UNKNOWN.
+         */
+        void clear();
+
+        /**
+         * @brief Insert a range measure.
+         * @param x0 The X-coordinate of the sensor.
+         * @param y0 The Y-coordinate of the sensor.
+         * @param x1 The X-coordinate of the end of the beam.
+         * @param y1 The Y-coordinate of the end of the beam.
+         * @param hit true if the beam ended on an echo; false if nothing was seen up to its end.
+         */
+        void insertRay(float x0, float y0, float x1, float y1, bool hit);
+
+        /**
+         * @brief Find the cell holding a world position.
+         * @return false if the position is outside the grid.
+         */
+        bool worldToCell(float x, float y, int16_t &cellX, int16_t &cellY) const;
+
+        /**
+         * @brief Get the world position of the center of a cell.
+         */
+        void cellToWorld(int16_t cellX, int16_t cellY, float &x, float &y) const;
+
+        CellState getCell(int16_t cellX, int16_t cellY) const;
+        void setCell(int16_t cellX, int16_t cellY, CellState state);
+
+        CellState getCellAt(float x, float y) const;
+        bool isFree(float x, float y) const { return getCellAt(x, y) == CELL_FREE; }
+        bool isOccupied(float x, float y) const { return getCellAt(x, y) >= CELL_LIKELY; }
+
+        /**
+         * @brief Mark the cell at a world position as occupied, e.g. on a bumper hit.
+         */
+        void markOccupied(float x, float y);
+
+        float getOriginX() const { return originX_; }
+        float getOriginY() const { return originY_; }
+        float getCellSize() const { return cellSize_; }
+        static uint8_t getSize() { return OCCUPANCY_GRID_SIZE; }
+
+      private:
+        int16_t toCell(float coordinate, float origin) const;
+
+        /** Move a cell one step toward CELL_FREE, or toward CELL_OCCUPIED if hit. */
+        void observe(int16_t cellX, int16_t cellY, bool hit);
+
+        uint8_t cells_[OCCUPANCY_GRID_SIZE * OCCUPANCY_GRID_SIZE / 4]; // 4 cells per byte, row major
+        float originX_;
+        float originY_;
+        float cellSize_;
+    };
+}
+
+#endif // OCCUPANCY_GRID_H
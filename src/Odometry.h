@@ -0,0 +1,153 @@
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include <Arduino.h>
+#include "Integration.h"
+#include "Calibration.h"
+
+#ifndef LS7366_COUNTER_BYTES
+#define LS7366_COUNTER_BYTES 4 // Width of the encoder counters, set by LibRobUS
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Dead-reckoning position of a differential-drive robot.
+     *
+     * Integrates the displacement of each update in Scalar, float or FixedPoint::Fixed, with the
+     * Method integrator. A fixed Method lets the compiler drop the other integrators; SELECTED keeps
+     * them all for setIntegrator(). Encoder ticks are turned into displacements here too, so the
+     * class runs without any hardware.
+     */
+    template<typename Scalar, Integrator Method = SELECTED>
+    class Odometry
+    {
+      public:
+        Odometry() : x_(0), y_(0), integrator_(Method == SELECTED ? ARC : Method),
+                     distancePerTick_(0.0000748f), trackWidth_(0.187f), previousLeftCount_(0),
+                     previousRightCount_(0), leftTicks_(0), rightTicks_(0), tickOrientationOffset_(0) {}
+
+        /**
+         * @brief Move the position along the displacement of one update.
+         * @param orientation The orientation at the start of the update, in radians.
+         * @param distance The distance travelled since the last update.
+         * @param rotation The change of orientation since the last update, in radians.
+         */
+        void update(Scalar orientation, Scalar distance, Scalar rotation) {
+            integrate(getIntegrator(), x_, y_, orientation, distance, rotation);
+        }
+
+        void setPosition(Scalar x, Scalar y) {
+            x_ = x;
+            y_ = y;
+        }
+
+        Scalar getX() const { return x_; }
+        Scalar getY() const { return y_; }
+
+        Integrator getIntegrator() const {
+            return Method == SELECTED ? integrator_ : Method;
+        }
+
+        /**
+         * @brief Set the integration method, only when the Method template parameter is SELECTED.
+         * @param method The integration method.
+         */
+        void setIntegrator(Integrator method) {
+            if (method != SELECTED) {
+                integrator_ = method;
+            }
+        }
+
+        /**
+         * @brief Turn the encoder counts into the displacement since the last call.
+         * @param leftCount The left encoder count.
+         * @param rightCount The right encoder count.
+         * @param distance Receives the distance travelled.
+         * @param rotation Receives the change of orientation, in radians.
+         */
+        void readTicks(int32_t leftCount, int32_t rightCount, float &distance, float &rotation) {
+            // Unsigned subtraction keeps the deltas right when a counter wraps around, the shifts
+            // sign-extend them from the counter width so narrower counters wrap right too.
+            const uint8_t shift = 32 - 8 * LS7366_COUNTER_BYTES;
+            int32_t left = (int32_t) (((uint32_t) leftCount - (uint32_t) previousLeftCount_) << shift) >> shift;
+            int32_t right = (int32_t) (((uint32_t) rightCount - (uint32_t) previousRightCount_) << shift) >> shift;
+            previousLeftCount_ = leftCount;
+            previousRightCount_ = rightCount;
+            leftTicks_ += left;
+            rightTicks_ += right;
+
+            float leftDistance = left * calibration_.leftScale;
+            float rightDistance = right * calibration_.rightScale;
+            distance = (leftDistance + rightDistance) * 0.5f * distancePerTick_;
+            rotation = (rightDistance - leftDistance) * distancePerTick_ / (trackWidth_ * calibration_.trackScale);
+        }
+
+        /**
+         * @brief Restart the encoder odometry from the given counts and orientation.
+         */
+        void resetTicks(int32_t leftCount, int32_t rightCount, float orientation) {
+            previousLeftCount_ = leftCount;
+            previousRightCount_ = rightCount;
+            restartTickOrientation(orientation);
+        }
+
+        /**
+         * @brief Get the orientation from the encoder ticks.
+         * @return The orientation in radians.
+         */
+        float getTickOrientation() const {
+            // Derived from the total ticks so rounding never accumulates in the heading.
+            float difference = rightTicks_ * calibration_.rightScale - leftTicks_ * calibration_.leftScale;
+            return tickOrientationOffset_ + difference * distancePerTick_ / (trackWidth_ * calibration_.trackScale);
+        }
+
+        /**
+         * @brief Set the wheel geometry, the encoder heading restarts from the given orientation.
+         * @param distancePerTick The distance travelled by a wheel for one encoder tick.
+         * @param trackWidth The distance between the two wheels.
+         * @param orientation The current orientation, in radians.
+         */
+        void setEncoderGeometry(float distancePerTick, float trackWidth, float orientation) {
+            distancePerTick_ = distancePerTick;
+            trackWidth_ = trackWidth;
+            restartTickOrientation(orientation);
+        }
+
+        float getDistancePerTick() const { return distancePerTick_; }
+        float getTrackWidth() const { return trackWidth_; }
+
+        /**
+         * @brief Set the wheel corrections, the encoder heading restarts from the given orientation.
+         * @param calibration The wheel and track width scales.
+         * @param orientation The current orientation, in radians.
+         */
+        void setCalibration(WheelCalibration calibration, float orientation) {
+            calibration_ = calibration;
+            restartTickOrientation(orientation);
+        }
+
+        WheelCalibration getCalibration() const { return calibration_; }
+
+      private:
+        void restartTickOrientation(float orientation) {
+            leftTicks_ = 0;
+            rightTicks_ = 0;
+            tickOrientationOffset_ = orientation;
+        }
+
+        Scalar x_;
+        Scalar y_;
+        Integrator integrator_;
+        float distancePerTick_;        // Distance travelled by a wheel for one encoder tick (3 inch wheel, 3200 ticks per turn)
+        float trackWidth_;             // Distance between the two wheels
+        int32_t previousLeftCount_;    // Left encoder count at the last update
+        int32_t previousRightCount_;   // Right encoder count at the last update
+        int32_t leftTicks_;            // Left ticks since the encoder heading was set
+        int32_t rightTicks_;           // Right ticks since the encoder heading was set
+        WheelCalibration calibration_; // Corrections of the wheel diameters and track width
+        float tickOrientationOffset_;  // Orientation when the encoder heading was set
+    };
+}
+
+#endif // ODOMETRY_H
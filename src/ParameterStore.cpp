@@ -0,0 +1,129 @@
+#include "ParameterStore.h"
+
+#define PARAMETER_STORE_MAGIC 0x5250 // "RP"
+#define POSE_SLOT_ERASED 0xFFFF      // Sequence number of a slot never written
+
+namespace RobusPosition
+{
+    namespace {
+        // CRC-16/CCITT-FALSE, 4 bits at a time.
+        const uint16_t CRC16_TABLE[16] PROGMEM = {
+            0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+            0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+        };
+
+        inline uint16_t crc16Update(uint16_t crc, uint8_t value) {
+            crc = (crc << 4) ^ pgm_read_word(&CRC16_TABLE[(crc >> 12) ^ (value >> 4)]);
+            return (crc << 4) ^ pgm_read_word(&CRC16_TABLE[(crc >> 12) ^ (value & 0x0F)]);
+        }
+    }
+
+    uint16_t crc16(uint16_t crc, const uint8_t *data, uint16_t size) {
+        for (uint16_t i = 0; i < size; i++) {
+            crc = crc16Update(crc, data[i]);
+        }
+        return crc;
+    }
+
+    ParameterStore::ParameterStore(uint16_t address) : address_(address), scanned_(false), newestSlot_(-1), sequence_(0) {}
+
+    uint16_t ParameterStore::getSize() {
+        return sizeof(ParameterBlock) + POSE_STORE_SLOTS * sizeof(PoseSlot);
+    }
+
+    uint16_t ParameterStore::slotAddress(uint8_t slot) const {
+        return address_ + sizeof(ParameterBlock) + slot * sizeof(PoseSlot);
+    }
+
+    bool ParameterStore::isValid(uint16_t address, uint16_t crcOffset) const {
+        uint16_t crc = 0xFFFF;
+        for (uint16_t i = 0; i < crcOffset; i++) {
+            crc = crc16Update(crc, EEPROM.read(address + i));
+        }
+        uint16_t stored;
+        EEPROM.get(address + crcOffset, stored);
+        return stored == crc;
+    }
+
+    void ParameterStore::saveParameters(const StoredParameters &parameters) {
+        ParameterBlock block;
+        memset((void *) &block, 0, sizeof(block)); // Padding included in the CRC
+        block.magic = PARAMETER_STORE_MAGIC;
+        block.version = PARAMETER_STORE_VERSION;
+        block.size = sizeof(StoredParameters);
+        block.parameters = parameters;
+        block.crc = crc16(0xFFFF, (const uint8_t *) &block, offsetof(ParameterBlock, crc));
+        EEPROM.put(address_, block);
+    }
+
+    bool ParameterStore::loadParameters(StoredParameters &parameters) const {
+        ParameterBlock block;
+        EEPROM.get(address_, block);
+        if (block.magic != PARAMETER_STORE_MAGIC || block.version != PARAMETER_STORE_VERSION ||
+            block.size != sizeof(StoredParameters) || crc16(0xFFFF, (const uint8_t *) &block, offsetof(ParameterBlock, crc)) != block.crc) {
+            return false;
+        }
+        parameters = block.parameters;
+        return true;
+    }
+
+    void ParameterStore::scan() {
+        // The newest slot has the highest sequence number, compared modulo 2^16. Only the sequence
+        // numbers are read, then the CRC of the candidate.
+        newestSlot_ = -1;
+        int8_t newest = -1;
+        uint16_t newestSequence = 0;
+        for (uint8_t slot = 0; slot < POSE_STORE_SLOTS; slot++) {
+            uint16_t sequence;
+            EEPROM.get(slotAddress(slot), sequence);
+            if (sequence == POSE_SLOT_ERASED) {
+                continue;
+            }
+            if (newest < 0 || (int16_t) (sequence - newestSequence) > 0) {
+                newest = slot;
+                newestSequence = sequence;
+            }
+        }
+
+        // A torn write leaves the newest slot invalid, fall back to the ones before it.
+        for (uint8_t tries = 0; newest >= 0 && tries < POSE_STORE_SLOTS; tries++) {
+            if (isValid(slotAddress(newest), offsetof(PoseSlot, crc))) {
+                EEPROM.get(slotAddress(newest), newestSequence);
+                newestSlot_ = newest;
+                break;
+            }
+            newest = newest == 0 ? POSE_STORE_SLOTS - 1 : newest - 1;
+        }
+        sequence_ = newestSlot_ >= 0 ? newestSequence : 0;
+        scanned_ = true;
+    }
+
+    void ParameterStore::savePose(const Pose &pose) {
+        if (!scanned_) {
+            scan();
+        }
+
+        PoseSlot slot;
+        memset((void *) &slot, 0, sizeof(slot));
+        slot.sequence = sequence_ + 1;
+        if (slot.sequence == POSE_SLOT_ERASED) {
+            slot.sequence = 0;
+        }
+        slot.pose = pose;
+        slot.crc = crc16(0xFFFF, (const uint8_t *) &slot, offsetof(PoseSlot, crc));
+
+        uint8_t next = newestSlot_ < 0 || newestSlot_ + 1 >= POSE_STORE_SLOTS ? 0 : newestSlot_ + 1;
+        EEPROM.put(slotAddress(next), slot);
+        newestSlot_ = next;
+        sequence_ = slot.sequence;
+    }
+
+    bool ParameterStore::loadPose(Pose &pose) {
+        scan();
+        if (newestSlot_ < 0) {
+            return false;
+        }
+        EEPROM.get(slotAddress(newestSlot_) + offsetof(PoseSlot, pose), pose);
+        return true;
+    }
+}
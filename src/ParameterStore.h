@@ -0,0 +1,117 @@
+#ifndef PARAMETER_STORE_H
+#define PARAMETER_STORE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Calibration.h"
+#include "PoseHistory.h"
+
+#ifndef PARAMETER_STORE_ADDRESS
+#define PARAMETER_STORE_ADDRESS 0
+#endif
+
+#ifndef POSE_STORE_SLOTS
+#define POSE_STORE_SLOTS 16 // Pose slots written in turn, each lasts POSE_STORE_SLOTS times longer
+#endif
+
+#define PARAMETER_STORE_VERSION 1 // Increase when StoredParameters changes
+
+namespace RobusPosition
+{
+    /**
+     * @brief Settings kept across resets.
+     */
+    struct StoredParameters {
+        float followVelocity;
+        float followAngularVelocityScale;
+        float curveTightness;
+        float lookaheadDistance;
+        float acceleration;
+        float deceleration;
+        float jerk;
+        float distancePerTick;
+        float trackWidth;
+        WheelCalibration calibration;
+        bool inverted;
+    };
+
+    /**
+     * @brief CRC-16/CCITT-FALSE of a block of bytes.
+     * @param crc The CRC of the previous bytes, 0xFFFF to start.
+     */
+    uint16_t crc16(uint16_t crc, const uint8_t *data, uint16_t size);
+
+    /**
+     * @brief Versioned and CRC-protected store of the parameters and the last pose in EEPROM.
+     *
+     * The parameter block holds a magic number, PARAMETER_STORE_VERSION and the size of
+     * StoredParameters, so a block saved by another layout is rejected instead of misread. It is
+     * followed by POSE_STORE_SLOTS pose slots written one after the other with an increasing
+     * sequence number: the newest slot with a valid CRC is the pose, and a write torn by a reset
+     * only loses the pose being saved.
+     *
+     * Loading reads the EEPROM directly and checks one CRC per block, a few hundred microseconds.
+     * Applying the parameters then rebuilds the speed curve table if the curve tightness changed,
+     * a few tens of milliseconds more on the Mega.
+     * Saving blocks about 3.3 ms per changed byte while the EEPROM is written.
+     */
+    class ParameterStore
+    {
+      public:
+        ParameterStore(uint16_t address = PARAMETER_STORE_ADDRESS);
+
+        void saveParameters(const StoredParameters &parameters);
+
+        /**
+         * @brief Read the parameters.
+         * @return false if no valid block of this version is saved; parameters is unchanged.
+         */
+        bool loadParameters(StoredParameters &parameters) const;
+
+        /**
+         * @brief Write the pose in the slot after the newest one.
+         */
+        void savePose(const Pose &pose);
+
+        /**
+         * @brief Read the newest valid pose.
+         * @return false if no pose is saved.
+         */
+        bool loadPose(Pose &pose);
+
+        /**
+         * @brief Get the EEPROM bytes used from the address of the store.
+         */
+        static uint16_t getSize();
+
+      private:
+        struct ParameterBlock {
+            uint16_t magic;
+            uint8_t version;
+            uint8_t size;
+            StoredParameters parameters;
+            uint16_t crc;
+        };
+
+        struct PoseSlot {
+            uint16_t sequence;
+            Pose pose;
+            uint16_t crc;
+        };
+
+        uint16_t slotAddress(uint8_t slot) const;
+
+        /** Check the CRC of a block in EEPROM, stored after the crcOffset bytes it covers. */
+        bool isValid(uint16_t address, uint16_t crcOffset) const;
+
+        /** Find the newest valid pose slot. */
+        void scan();
+
+        uint16_t address_;
+        bool scanned_;          // Whether newestSlot_ and sequence_ were read from the EEPROM
+        int8_t newestSlot_;     // Slot of the newest valid pose, -1 if none
+        uint16_t sequence_;     // Sequence number of the newest pose
+    };
+}
+
+#endif // PARAMETER_STORE_H
@@ -0,0 +1,136 @@
+#include "PoseFilter.h"
+
+namespace RobusPosition
+{
+    PoseFilter::PoseFilter() : distanceNoise_(0.0005f), rotationNoise_(0.002f), driftNoise_(0.002f), wallCount_(0) {}
+
+    void PoseFilter::reset(float positionVariance, float orientationVariance) {
+        covariance_.fill(0);
+        covariance_(0, 0) = positionVariance;
+        covariance_(1, 1) = positionVariance;
+        covariance_(2, 2) = orientationVariance;
+    }
+
+    void PoseFilter::setNoise(float distance, float rotation, float drift) {
+        distanceNoise_ = distance;
+        rotationNoise_ = rotation;
+        driftNoise_ = drift;
+    }
+
+    void PoseFilter::predict(float orientation, float distance, float rotation) {
+        float heading = orientation + rotation / 2;
+        float cosine = cos(heading);
+        float sine = sin(heading);
+
+        // Derivative of the midpoint step with respect to the pose...
+        Matrix<3, 3> jacobian = Matrix<3, 3>::identity();
+        jacobian(0, 2) = -distance * sine;
+        jacobian(1, 2) = distance * cosine;
+
+        // ... and with respect to the (distance, rotation) odometry measure.
+        Matrix<3, 2> control;
+        control(0, 0) = cosine;
+        control(0, 1) = -distance / 2 * sine;
+        control(1, 0) = sine;
+        control(1, 1) = distance / 2 * cosine;
+        control(2, 1) = 1;
+
+        float travelled = fabs(distance);
+        Matrix<2, 2> noise;
+        noise(0, 0) = distanceNoise_ * travelled;
+        noise(1, 1) = rotationNoise_ * fabs(rotation) + driftNoise_ * travelled;
+
+        covariance_ = jacobian * covariance_ * jacobian.transpose() + control * noise * control.transpose();
+    }
+
+    bool PoseFilter::expectedRange(const Pose &pose, const RangeSensor &sensor, float &range, Matrix<1, 3> &jacobian) const {
+        float cosine = cos(pose.orientation);
+        float sine = sin(pose.orientation);
+        float sensorX = pose.x + cosine * sensor.x - sine * sensor.y;
+        float sensorY = pose.y + sine * sensor.x + cosine * sensor.y;
+        float beam = pose.orientation + sensor.angle;
+        float beamX = cos(beam);
+        float beamY = sin(beam);
+
+        bool found = false;
+        for (uint8_t i = 0; i < wallCount_; i++) {
+            const Wall &wall = walls_[i];
+            float wallX = wall.x2 - wall.x1;
+            float wallY = wall.y2 - wall.y1;
+            float length = sqrt(wallX * wallX + wallY * wallY);
+            if (length <= 0) {
+                continue;
+            }
+            float normalX = -wallY / length;
+            float normalY = wallX / length;
+
+            // Walls seen at a grazing angle reflect the sonar away, their measures are not trusted.
+            float incidence = normalX * beamX + normalY * beamY;
+            if (fabs(incidence) < POSE_FILTER_MIN_INCIDENCE) {
+                continue;
+            }
+
+            float distance = (normalX * (wall.x1 - sensorX) + normalY * (wall.y1 - sensorY)) / incidence;
+            if (distance <= 0 || (found && distance >= range)) {
+                continue;
+            }
+
+            float along = ((sensorX + distance * beamX - wall.x1) * wallX + (sensorY + distance * beamY - wall.y1) * wallY) / (length * length);
+            if (along < 0 || along > 1) {
+                continue;
+            }
+
+            // Moving the sensor along the normal or turning the beam changes the range.
+            float sensorTurnX = -sine * sensor.x - cosine * sensor.y;
+            float sensorTurnY = cosine * sensor.x - sine * sensor.y;
+            float beamTurn = normalX * -beamY + normalY * beamX;
+            range = distance;
+            jacobian(0, 0) = -normalX / incidence;
+            jacobian(0, 1) = -normalY / incidence;
+            jacobian(0, 2) = (-(normalX * sensorTurnX + normalY * sensorTurnY) - distance * beamTurn) / incidence;
+            found = true;
+        }
+        return found;
+    }
+
+    bool PoseFilter::correct(Pose &pose, const RangeSensor &sensor, float range) {
+        if (!(range >= sensor.minRange && range <= sensor.maxRange)) {
+            return false;
+        }
+
+        float expected;
+        Matrix<1, 3> jacobian;
+        if (!expectedRange(pose, sensor, expected, jacobian)) {
+            return false;
+        }
+
+        float innovation = range - expected;
+        Matrix<3, 1> crossCovariance = covariance_ * jacobian.transpose();
+        float innovationVariance = (jacobian * crossCovariance)(0, 0) + sensor.variance;
+        if (innovation * innovation > POSE_FILTER_GATE * innovationVariance) {
+            return false;
+        }
+
+        Matrix<3, 1> gain = crossCovariance * (1 / innovationVariance);
+        pose.x += gain(0, 0) * innovation;
+        pose.y += gain(1, 0) * innovation;
+        pose.orientation += gain(2, 0) * innovation;
+
+        // Joseph form, keeps the covariance symmetric and positive in single precision.
+        Matrix<3, 3> update = Matrix<3, 3>::identity() - gain * jacobian;
+        covariance_ = update * covariance_ * update.transpose() + gain * gain.transpose() * sensor.variance;
+        return true;
+    }
+
+    bool PoseFilter::addWall(Wall wall) {
+        if (wallCount_ >= POSE_FILTER_WALL_COUNT) {
+            return false;
+        }
+        walls_[wallCount_++] = wall;
+        return true;
+    }
+
+    void PoseFilter::clearWalls() {
+        wallCount_ = 0;
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef POSE_FILTER_H
+#define POSE_FILTER_H
+
+#include <Arduino.h>
+#include "Matrix.h"
+#include "PoseHistory.h"
+
+#ifndef POSE_FILTER_WALL_COUNT
+#define POSE_FILTER_WALL_COUNT 8
+#endif
+
+#ifndef POSE_FILTER_GATE
+#define POSE_FILTER_GATE 9.0f // Squared innovation over its variance, 3 sigma
+#endif
+
+#ifndef POSE_FILTER_MIN_INCIDENCE
+#define POSE_FILTER_MIN_INCIDENCE 0.5f // Cosine of the largest angle between a beam and a wall normal, 60 degrees
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Straight wall segment at a known position.
+     */
+    struct Wall {
+        Wall(float x1 = 0, float y1 = 0, float x2 = 0, float y2 = 0) : x1(x1), y1(y1), x2(x2), y2(y2) {}
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+    };
+
+    /**
+     * @brief Range sensor mounted on the robot.
+     *
+     * A maximum range of zero disables the sensor.
+     */
+    struct RangeSensor {
+        RangeSensor(float x = 0, float y = 0, float angle = 0, float variance = 0.0004f,
+                    float minRange = 0, float maxRange = 0)
+            : x(x), y(y), angle(angle), variance(variance), minRange(minRange), maxRange(maxRange) {}
+        float x;        /**< Forward offset from the center of the wheels. */
+        float y;        /**< Leftward offset from the center of the wheels. */
+        float angle;    /**< Direction of the beam from the robot heading, in radians. */
+        float variance; /**< Variance of a measure. */
+        float minRange; /**< Shortest trusted measure. */
+        float maxRange; /**< Longest trusted measure. */
+    };
+
+    /**
+     * @brief Extended Kalman filter on the (x, y, orientation) pose of the robot.
+     *
+     * The pose itself stays with the odometry: predict() only grows the covariance along with
+     * each odometry step, and correct() moves the given pose toward a range measure of one of
+     * the known walls. Everything is statically sized, the walls included.
+     */
+    class PoseFilter
+    {
+      public:
+        PoseFilter();
+
+        /**
+         * @brief Set the uncertainty of the current pose, without correlation between its terms.
+         * @param positionVariance Variance of both coordinates.
+         * @param orientationVariance Variance of the orientation, in radians squared.
+         */
+        void reset(float positionVariance, float orientationVariance);
+
+        /**
+         * @brief Set how fast the odometry error grows.
+         * @param distance Variance of the travelled distance per unit travelled.
+         * @param rotation Variance of the rotation per radian turned.
+         * @param drift Variance of the rotation per unit travelled.
+         */
+        void setNoise(float distance, float rotation, float drift);
+
+        /**
+         * @brief Propagate the covariance through one odometry step.
+         * @param orientation The orientation at the start of the step, in radians.
+         * @param distance The distance travelled during the step.
+         * @param rotation The change of orientation during the step, in radians.
+         */
+        void predict(float orientation, float distance, float rotation);
+
+        /**
+         * @brief Correct a pose with the range measured to the closest wall.
+         *
+         * Measures outside the range of the sensor, beams hitting no wall or hitting one at a grazing
+         * angle, and measures further than POSE_FILTER_GATE from the prediction are rejected.
+         *
+         * @param pose The pose, updated in place.
+         * @param sensor The sensor that took the measure.
+         * @param range The measured range.
+         * @return true if the measure was used; otherwise, false.
+         */
+        bool correct(Pose &pose, const RangeSensor &sensor, float range);
+
+        /**
+         * @brief Compute the range a sensor should measure from a pose.
+         * @param pose The pose of the robot.
+         * @param sensor The sensor.
+         * @param range Receives the distance to the closest wall along the beam.
+         * @param jacobian Receives the derivative of the range with respect to the pose.
+         * @return false if the beam hits no wall at a usable angle.
+         */
+        bool expectedRange(const Pose &pose, const RangeSensor &sensor, float &range, Matrix<1, 3> &jacobian) const;
+
+        /**
+         * @brief Add a wall to the map.
+         * @return false if the map is full.
+         */
+        bool addWall(Wall wall);
+        void clearWalls();
+        uint8_t getWallCount() const { return wallCount_; }
+
+        /**
+         * @brief Get the covariance of (x, y, orientation).
+         */
+        const Matrix<3, 3> &getCovariance() const { return covariance_; }
+
+      private:
+        Matrix<3, 3> covariance_;
+        float distanceNoise_;
+        float rotationNoise_;
+        float driftNoise_;
+        Wall walls_[POSE_FILTER_WALL_COUNT];
+        uint8_t wallCount_;
+    };
+}
+
+#endif // POSE_FILTER_H
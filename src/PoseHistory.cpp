@@ -0,0 +1,77 @@
+#include "PoseHistory.h"
+
+namespace RobusPosition
+{
+    PoseHistory::PoseHistory() {
+        clear();
+    }
+
+    void PoseHistory::clear() {
+        first_ = 0;
+        count_ = 0;
+    }
+
+    uint8_t PoseHistory::index(uint8_t i) const {
+        uint16_t position = (uint16_t) first_ + i;
+        return position >= POSE_HISTORY_SIZE ? position - POSE_HISTORY_SIZE : position;
+    }
+
+    void PoseHistory::record(unsigned long time, Pose pose) {
+        uint8_t slot;
+        if (count_ < POSE_HISTORY_SIZE) {
+            slot = index(count_);
+            count_++;
+        } else {
+            slot = first_;
+            first_ = index(1);
+        }
+        times_[slot] = time;
+        poses_[slot] = pose;
+    }
+
+    bool PoseHistory::getPoseAt(unsigned long time, Pose &pose) const {
+        if (count_ == 0) {
+            return false;
+        }
+
+        // Work with ages relative to the newest record so micros() overflow does not break the ordering.
+        unsigned long newest = times_[index(count_ - 1)];
+        if ((long) (time - newest) >= 0) {
+            pose = poses_[index(count_ - 1)];
+            return true;
+        }
+        unsigned long age = newest - time;
+        if (age > newest - times_[first_]) {
+            return false;
+        }
+
+        // Find the last record at least as old as the requested time, ages decrease with i.
+        uint8_t low = 0;
+        uint8_t high = count_ - 1;
+        while (high - low > 1) {
+            uint8_t middle = (low + high) / 2;
+            if (newest - times_[index(middle)] >= age) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+
+        const Pose &before = poses_[index(low)];
+        const Pose &after = poses_[index(high)];
+        unsigned long span = times_[index(high)] - times_[index(low)];
+        float t = span > 0 ? (float) (time - times_[index(low)]) / span : 0;
+
+        float rotation = after.orientation - before.orientation;
+        if (rotation > PI) {
+            rotation -= TWO_PI;
+        } else if (rotation < -PI) {
+            rotation += TWO_PI;
+        }
+
+        pose.x = before.x + (after.x - before.x) * t;
+        pose.y = before.y + (after.y - before.y) * t;
+        pose.orientation = before.orientation + rotation * t;
+        return true;
+    }
+}
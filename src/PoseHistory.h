@@ -0,0 +1,73 @@
+#ifndef POSE_HISTORY_H
+#define POSE_HISTORY_H
+
+#include <Arduino.h>
+
+#ifndef POSE_HISTORY_SIZE
+#define POSE_HISTORY_SIZE 32
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Position and orientation of the robot.
+     */
+    struct Pose {
+        Pose(float x = 0, float y = 0, float orientation = 0) : x(x), y(y), orientation(orientation) {}
+        float x;
+        float y;
+        float orientation; /**< Orientation in radians. */
+    };
+
+    /**
+     * @brief Fixed-capacity history of timestamped poses.
+     *
+     * Keeps the last POSE_HISTORY_SIZE poses in a statically allocated ring buffer so a sensor
+     * reading can be matched with the pose the robot had when it was taken.
+     */
+    class PoseHistory
+    {
+      public:
+        PoseHistory();
+
+        /**
+         * @brief Add a pose to the history, dropping the oldest one when full.
+         * @param time Timestamp of the pose in microseconds, from micros(). Must not go backward.
+         * @param pose The pose.
+         */
+        void record(unsigned long time, Pose pose);
+
+        /**
+         * @brief Get the pose at a given time, interpolated between the two closest records.
+         *
+         * Runs a binary search, O(log n). Times more recent than the last record return the last pose.
+         *
+         * @param time Timestamp in microseconds, from micros().
+         * @param pose Receives the pose.
+         * @return false if the history is empty or does not reach back to that time.
+         */
+        bool getPoseAt(unsigned long time, Pose &pose) const;
+
+        /**
+         * @brief Remove all the poses from the history.
+         */
+        void clear();
+
+        /**
+         * @brief Get the number of poses in the history.
+         * @return The number of poses.
+         */
+        uint8_t size() const { return count_; }
+
+      private:
+        /** Index in the buffer of the i-th oldest record. */
+        uint8_t index(uint8_t i) const;
+
+        unsigned long times_[POSE_HISTORY_SIZE];
+        Pose poses_[POSE_HISTORY_SIZE];
+        uint8_t first_; // Index of the oldest record
+        uint8_t count_; // Number of records
+    };
+}
+
+#endif // POSE_HISTORY_H
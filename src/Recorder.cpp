@@ -0,0 +1,130 @@
+#include "Recorder.h"
+
+#define RECORDER_MAGIC 0x43525052 // "RPRC"
+
+namespace RobusPosition
+{
+    namespace {
+        // AVR and x86 are both little-endian, the fields are copied as they are in memory.
+        template<typename T>
+        uint8_t *put(uint8_t *buffer, T value) {
+            memcpy(buffer, &value, sizeof(T));
+            return buffer + sizeof(T);
+        }
+
+        template<typename T>
+        const uint8_t *take(const uint8_t *buffer, T &value) {
+            memcpy(&value, buffer, sizeof(T));
+            return buffer + sizeof(T);
+        }
+    }
+
+    void Recorder::record(const RecordEntry &entry) {
+        if (!recording_) {
+            return;
+        }
+        entries_[head_] = entry;
+        head_ = head_ + 1 < RECORDER_SIZE ? head_ + 1 : 0;
+        if (count_ < RECORDER_SIZE) {
+            count_++;
+        }
+    }
+
+    const RecordEntry &Recorder::get(uint16_t i) const {
+        uint16_t index = head_ + RECORDER_SIZE - count_ + i;
+        return entries_[index < RECORDER_SIZE ? index : index - RECORDER_SIZE];
+    }
+
+    void Recorder::encodeHeader(const RecordHeader &header, uint8_t *buffer) {
+        const StoredParameters &parameters = header.parameters;
+        buffer = put<uint32_t>(buffer, RECORDER_MAGIC);
+        buffer = put<uint8_t>(buffer, RECORDER_VERSION);
+        buffer = put<uint8_t>(buffer, RECORDER_ENTRY_SIZE);
+        buffer = put(buffer, header.integrator);
+        buffer = put(buffer, header.fixedRateFrequency);
+        buffer = put(buffer, header.count);
+        buffer = put(buffer, parameters.followVelocity);
+        buffer = put(buffer, parameters.followAngularVelocityScale);
+        buffer = put(buffer, parameters.curveTightness);
+        buffer = put(buffer, parameters.lookaheadDistance);
+        buffer = put(buffer, parameters.acceleration);
+        buffer = put(buffer, parameters.deceleration);
+        buffer = put(buffer, parameters.jerk);
+        buffer = put(buffer, parameters.distancePerTick);
+        buffer = put(buffer, parameters.trackWidth);
+        buffer = put(buffer, parameters.calibration.leftScale);
+        buffer = put(buffer, parameters.calibration.rightScale);
+        buffer = put(buffer, parameters.calibration.trackScale);
+        put<uint8_t>(buffer, parameters.inverted);
+    }
+
+    bool Recorder::decodeHeader(const uint8_t *buffer, RecordHeader &header) {
+        uint32_t magic;
+        uint8_t version, entrySize, inverted;
+        StoredParameters &parameters = header.parameters;
+        buffer = take(buffer, magic);
+        buffer = take(buffer, version);
+        buffer = take(buffer, entrySize);
+        if (magic != RECORDER_MAGIC || version != RECORDER_VERSION || entrySize != RECORDER_ENTRY_SIZE) {
+            return false;
+        }
+        buffer = take(buffer, header.integrator);
+        buffer = take(buffer, header.fixedRateFrequency);
+        buffer = take(buffer, header.count);
+        buffer = take(buffer, parameters.followVelocity);
+        buffer = take(buffer, parameters.followAngularVelocityScale);
+        buffer = take(buffer, parameters.curveTightness);
+        buffer = take(buffer, parameters.lookaheadDistance);
+        buffer = take(buffer, parameters.acceleration);
+        buffer = take(buffer, parameters.deceleration);
+        buffer = take(buffer, parameters.jerk);
+        buffer = take(buffer, parameters.distancePerTick);
+        buffer = take(buffer, parameters.trackWidth);
+        buffer = take(buffer, parameters.calibration.leftScale);
+        buffer = take(buffer, parameters.calibration.rightScale);
+        buffer = take(buffer, parameters.calibration.trackScale);
+        take(buffer, inverted);
+        parameters.inverted = inverted;
+        return true;
+    }
+
+    void Recorder::encodeEntry(const RecordEntry &entry, uint8_t *buffer) {
+        buffer = put(buffer, entry.inputs.time);
+        if (entry.flags & RecordEntry::ENCODER) {
+            buffer = put(buffer, entry.inputs.encoder.left);
+            buffer = put(buffer, entry.inputs.encoder.right);
+        } else {
+            buffer = put(buffer, entry.inputs.movement.velocity);
+            buffer = put(buffer, entry.inputs.movement.angularVelocity);
+        }
+        buffer = put(buffer, entry.inputs.orientation);
+        buffer = put(buffer, entry.targetX);
+        buffer = put(buffer, entry.targetY);
+        buffer = put(buffer, entry.x);
+        buffer = put(buffer, entry.y);
+        buffer = put(buffer, entry.orientation);
+        put(buffer, entry.flags);
+    }
+
+    void Recorder::decodeEntry(const uint8_t *buffer, RecordEntry &entry) {
+        buffer = take(buffer, entry.inputs.time);
+        const uint8_t *source = buffer;
+        buffer += 8;
+        buffer = take(buffer, entry.inputs.orientation);
+        buffer = take(buffer, entry.targetX);
+        buffer = take(buffer, entry.targetY);
+        buffer = take(buffer, entry.x);
+        buffer = take(buffer, entry.y);
+        buffer = take(buffer, entry.orientation);
+        take(buffer, entry.flags);
+
+        // The flags at the end tell how to read the source readings.
+        if (entry.flags & RecordEntry::ENCODER) {
+            source = take(source, entry.inputs.encoder.left);
+            take(source, entry.inputs.encoder.right);
+        } else {
+            source = take(source, entry.inputs.movement.velocity);
+            take(source, entry.inputs.movement.angularVelocity);
+        }
+    }
+}
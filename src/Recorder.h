@@ -0,0 +1,115 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <Arduino.h>
+#include "ParameterStore.h"
+
+#ifndef RECORDER_SIZE
+#define RECORDER_SIZE 32 // Updates kept, 37 bytes each
+#endif
+
+#define RECORDER_VERSION 1
+#define RECORDER_HEADER_SIZE 60
+#define RECORDER_ENTRY_SIZE 37
+
+namespace RobusPosition
+{
+    /**
+     * @brief Hardware readings used by one update.
+     */
+    struct UpdateInputs {
+        struct Movement {
+            float velocity;
+            float angularVelocity;
+        };
+
+        struct Encoder {
+            int32_t left;
+            int32_t right;
+        };
+
+        uint32_t time;         /**< Timestamp of the update, in microseconds. */
+        union {
+            Movement movement; /**< RobusMovement velocities, with MOVEMENT_VELOCITY. */
+            Encoder encoder;   /**< Encoder counts, with ENCODER_TICKS. */
+        };
+        float orientation;     /**< RobusMovement heading in radians, with MOVEMENT_VELOCITY. */
+    };
+
+    /**
+     * @brief One recorded update: its inputs, the target it followed and the pose it computed.
+     */
+    struct RecordEntry {
+        enum Flags {
+            FOLLOWING = 1,  /**< The follower drove the robot. */
+            ENCODER = 2     /**< The odometry source was ENCODER_TICKS. */
+        };
+
+        UpdateInputs inputs;
+        float targetX;
+        float targetY;
+        float x;
+        float y;
+        float orientation;
+        uint8_t flags;
+    };
+
+    /**
+     * @brief Recording settings written before the entries.
+     */
+    struct RecordHeader {
+        uint8_t integrator;
+        uint16_t fixedRateFrequency; /**< Rate of the fixed-rate mode, 0 for update() from loop(). */
+        uint16_t count;
+        StoredParameters parameters;
+    };
+
+    /**
+     * @brief Ring buffer of the last RECORDER_SIZE updates, for a replay on the host.
+     *
+     * The dump is a RECORDER_HEADER_SIZE header then RECORDER_ENTRY_SIZE bytes per entry, oldest
+     * first, every field little-endian without padding so AVR and host read the same bytes.
+     */
+    class Recorder
+    {
+      public:
+        Recorder() : head_(0), count_(0), recording_(false) {}
+
+        /**
+         * @brief Forget the recorded updates and record the next ones.
+         */
+        void start() {
+            head_ = 0;
+            count_ = 0;
+            recording_ = true;
+        }
+
+        void stop() { recording_ = false; }
+        bool isRecording() const { return recording_; }
+
+        /**
+         * @brief Add an update, overwriting the oldest when full.
+         */
+        void record(const RecordEntry &entry);
+
+        uint16_t getCount() const { return count_; }
+
+        /**
+         * @brief Get an update, 0 being the oldest.
+         */
+        const RecordEntry &get(uint16_t i) const;
+
+        static void encodeHeader(const RecordHeader &header, uint8_t *buffer);
+        static bool decodeHeader(const uint8_t *buffer, RecordHeader &header);
+        static void encodeEntry(const RecordEntry &entry, uint8_t *buffer);
+        static void decodeEntry(const uint8_t *buffer, RecordEntry &entry);
+
+      private:
+        RecordEntry entries_[RECORDER_SIZE];
+        uint16_t head_;     // Slot of the next update
+        uint16_t count_;
+        bool recording_;
+    };
+}
+
+#endif // RECORDER_H
@@ -1,38 +1,220 @@
 #include "RobusPosition.h"
 
-#ifndef INTEGRATION_ITERATION
-#define INTEGRATION_ITERATION 1
+#ifdef __AVR__
+#include <SPI.h>
+#include <util/atomic.h>
+// Block for reads and writes shared with the fixed-rate interrupt.
+#define POSITION_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define POSITION_ATOMIC
 #endif
 
+#define TIMER5_TICKS_PER_SECOND (F_CPU / 8) // Timer5 at clk/8
+
 namespace RobusPosition
 {
-    // Helper function to normalize an angle to the range [0, 2*PI]
-    float normalizeAngle(float angle) {
-        while (angle < 0) {
-            angle += TWO_PI;
+    /**
+     * @brief Hold back the fixed-rate interrupt while loop() works on state used by the update.
+     *
+     * Only the Timer5 compare B interrupt is masked, a compare that happens meanwhile runs as soon
+     * as it is released, so the rest of the system keeps its interrupts during the computation.
+     *
+     * @return Whether the fixed-rate interrupt was enabled, to pass to releaseFixedRate().
+     */
+    bool holdFixedRate() {
+        bool enabled = false;
+#ifdef __AVR__
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            enabled = TIMSK5 & _BV(OCIE5B);
+            TIMSK5 &= ~_BV(OCIE5B);
         }
-        while (angle >= TWO_PI) {
-            angle -= TWO_PI;
+#endif
+        return enabled;
+    }
+
+    void releaseFixedRate(bool enabled) {
+#ifdef __AVR__
+        if (enabled) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                TIMSK5 |= _BV(OCIE5B);
+            }
         }
-        return angle;
+#else
+        (void) enabled;
+#endif
     }
 
-    float smallestSignedAngle(float currentAngle, float targetAngle) {
-        // Ensure both angles are in the range [0, 2*PI]
-        currentAngle = normalizeAngle(currentAngle);
-        targetAngle = normalizeAngle(targetAngle);
+    /**
+     * @brief Read the orientation from the odometry source, bypassing the pose snapshot.
+     * @return The orientation angle of the robot in radians.
+     */
+    float readOrientation() {
+        float heading;
+        if (odometrySource == ENCODER_TICKS) {
+            heading = odometry.getTickOrientation();
+        } else {
+            heading = RobusMovement::computeOrientation();
+        }
+        return heading + orientationCorrection;
+    }
 
-        // Calculate the difference between the angles
-        float angleDifference = targetAngle - currentAngle;
+    /**
+     * @brief Read the hardware used by an update, for the current odometry source.
+     * @param time Timestamp of the update, in microseconds.
+     * @param inputs Receives the readings.
+     */
+    void readInputs(unsigned long time, UpdateInputs &inputs) {
+        inputs.time = time;
+        if (odometrySource == ENCODER_TICKS) {
+            // Both counters latched at once, a skew between them would show up as heading error.
+            EncoderCounts counts = ENCODER_ReadBoth();
+            inputs.encoder.left = counts.left;
+            inputs.encoder.right = counts.right;
+            inputs.orientation = 0;
+        } else {
+            inputs.movement.velocity = RobusMovement::getVelocity();
+            inputs.movement.angularVelocity = RobusMovement::getAngularVelocity();
+            inputs.orientation = RobusMovement::computeOrientation();
+        }
+    }
 
-        // Normalize the angle difference to be in the range [-PI, PI]
-        if (angleDifference > PI) {
-            angleDifference -= TWO_PI;
-        } else if (angleDifference < -PI) {
-            angleDifference += TWO_PI;
+    /**
+     * @brief Turn the readings of an update into the displacement of the robot since the last one.
+     * @param inputs The readings from readInputs().
+     * @param dt Elapsed time since the last update, in seconds.
+     * @param orientation Receives the orientation at the start of the update, in radians.
+     * @param distance Receives the distance travelled since the last update.
+     * @param rotation Receives the change of orientation since the last update, in radians.
+     */
+    void readOdometry(const UpdateInputs &inputs, float dt, float &orientation, float &distance, float &rotation) {
+        if (odometrySource == ENCODER_TICKS) {
+            orientation = readOrientation();
+            odometry.readTicks(inputs.encoder.left, inputs.encoder.right, distance, rotation);
+        } else {
+            distance = inputs.movement.velocity * dt;
+            rotation = inputs.movement.angularVelocity * dt;
+            // computeOrientation() already includes this rotation, step back to the start of the interval.
+            orientation = inputs.orientation + orientationCorrection - rotation;
         }
 
-        return angleDifference;
+        if (inverted) {
+            distance = -distance;
+        }
+    }
+
+    /**
+     * @brief Aim the follower at the next corner of the calibration square, or end the run.
+     */
+    void advanceCalibrationRun() {
+        static const int8_t CORNER_X[4] = {1, 1, 0, 0};
+        static const int8_t CORNER_Y[4] = {0, 1, 1, 0};
+
+        if (calibrationLeg >= 4) {
+            calibrationLeg = 0;
+            follower.stop();
+            return;
+        }
+
+        float side = umbmark.getSide();
+        float x = CORNER_X[calibrationLeg] * side;
+        float y = (calibrationClockwise ? -CORNER_Y[calibrationLeg] : CORNER_Y[calibrationLeg]) * side;
+        float cosine = cos(calibrationStart.orientation);
+        float sine = sin(calibrationStart.orientation);
+        follower.setTarget(calibrationStart.x + x * cosine - y * sine, calibrationStart.y + x * sine + y * cosine);
+        calibrationLeg++;
+    }
+
+    /**
+     * @brief Fill the pose snapshot once for this update.
+     * @param time Timestamp of the update, in microseconds.
+     * @param dt Elapsed time since the last update, in seconds.
+     * @param orientation The orientation at the start of the update read by readOdometry(), in radians.
+     * @param distance The distance travelled since the last update.
+     * @param rotation The change of orientation since the last update, in radians.
+     */
+    void refreshSnapshot(unsigned long time, float dt, float orientation, float distance, float rotation) {
+        // The encoder heading is read again after the new ticks, the RobusMovement heading is the end of the interval.
+        if (odometrySource == ENCODER_TICKS) {
+            orientation = readOrientation();
+        } else {
+            orientation += rotation;
+        }
+
+        float x = (float) odometry.getX();
+        float y = (float) odometry.getY();
+        // Readers polling the generation only see a new one when the robot actually moved or turned.
+        if (x != snapshot.x || y != snapshot.y || orientation != snapshot.orientation) {
+            snapshot.generation++;
+        }
+
+        snapshot.x = x;
+        snapshot.y = y;
+#ifdef ROBUS_POSITION_FIXED_POINT
+        FixedPoint::Fixed cosine, sine;
+        FixedPoint::sincos(FixedPoint::Fixed(orientation), cosine, sine);
+        snapshot.cosOrientation = cosine.toFloat();
+        snapshot.sinOrientation = sine.toFloat();
+#else
+        snapshot.cosOrientation = positionCos(orientation);
+        snapshot.sinOrientation = positionSin(orientation);
+#endif
+        snapshot.orientation = orientation;
+        snapshot.velocity = dt > 0 ? distance / dt : 0;
+        snapshot.angularVelocity = dt > 0 ? rotation / dt : 0;
+        snapshot.time = time;
+    }
+
+    /**
+     * @brief Run the odometry and the target follower for one control period.
+     * @param inputs The hardware readings of this update.
+     * @param dt Elapsed time since the last update, in seconds.
+     */
+    void tick(const UpdateInputs &inputs, float dt) {
+        unsigned long time = inputs.time;
+#ifdef ROBUS_POSITION_RECORDER
+        bool following = follower.isFollowing();
+#endif
+        float orientation, distance, rotation;
+        readOdometry(inputs, dt, orientation, distance, rotation);
+
+        odometry.update(PositionScalar(orientation), PositionScalar(distance), PositionScalar(rotation));
+        if (poseFilterEnabled) {
+            poseFilter.predict(orientation, distance, rotation);
+        }
+        refreshSnapshot(time, dt, orientation, distance, rotation);
+
+        if (follower.isFollowing()) {
+            float velocity, angularVelocity;
+            if (follower.update(odometry.getX(), odometry.getY(), PositionScalar(snapshot.orientation), dt, velocity, angularVelocity)) {
+                RobusMovement::setVelocity(velocity);
+                RobusMovement::setAngularVelocity(angularVelocity);
+            } else {
+                RobusMovement::stop();
+                if (calibrationLeg != 0) {
+                    advanceCalibrationRun();
+                }
+            }
+        }
+
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+        poseHistory.record(time, Pose(snapshot.x, snapshot.y, snapshot.orientation));
+#endif
+
+#ifdef ROBUS_POSITION_RECORDER
+        if (recorder.isRecording()) {
+            RecordEntry entry;
+            entry.inputs = inputs;
+            entry.targetX = follower.getTargetX();
+            entry.targetY = follower.getTargetY();
+            entry.x = snapshot.x;
+            entry.y = snapshot.y;
+            entry.orientation = snapshot.orientation;
+            entry.flags = (following ? RecordEntry::FOLLOWING : 0) | (odometrySource == ENCODER_TICKS ? RecordEntry::ENCODER : 0);
+            recorder.record(entry);
+        }
+#endif
+
+        RobusMovement::update();
     }
 
     /**
@@ -40,64 +222,168 @@ namespace RobusPosition
      *
      * This function updates the robot's position based on its current velocity and orientation.
      * If the robot is set to follow a target, it adjusts its velocity and angular velocity accordingly.
+     * Does nothing while the fixed-rate mode runs the updates from the timer interrupt.
      */
     void update() {
-        static unsigned long oldTime;
-        unsigned long time = micros();
-        float dt = (time - oldTime) / 1000000.0;
-        oldTime = time;
-
-        const double robusVelocity = (double) RobusMovement::getVelocity() * (inverted ? -1 : 1);
-        const double robusAngularVelocity = (double) RobusMovement::getAngularVelocity();
-        double robusOrientation = (double) RobusMovement::computeOrientation();
-
-        double iterationDt = dt / INTEGRATION_ITERATION;
-        for (int i = 0; i < INTEGRATION_ITERATION; i++) {
-            position.x += cos(robusOrientation) * robusVelocity * iterationDt;
-            position.y += sin(robusOrientation) * robusVelocity * iterationDt;
-            robusOrientation += robusAngularVelocity * iterationDt;
-        }
-
-        if (followingTarget) {
-            float targetDistance = dist(position.x, position.y, target.x, target.y);
-            if (targetDistance > 0.01) {
-                Vector targetDirection = Vector(0, 0);
-                targetDirection.x = (target.x - position.x) / targetDistance;
-                targetDirection.y = (target.y - position.y) / targetDistance;
-
-                float targetAngle = atan2(targetDirection.y, targetDirection.x);
-
-                float robusOrientation = RobusMovement::computeOrientation();
-                Vector robusDirection = Vector(0, 0);
-                robusDirection.x = cos(robusOrientation);
-                robusDirection.y = sin(robusOrientation);
-
-                float directionDot = robusDirection.x * targetDirection.x + robusDirection.y * targetDirection.y;
-                float velocity = pow(constrain(0, directionDot, 1), curveTightness) * followVelocity * (inverted ? -1 : 1);
-                
-                float deltaOrientation = smallestSignedAngle(robusOrientation, targetAngle);
-                float angularVelocity = deltaOrientation * followAngularVelocityScale;
-                
-                //float distanceError = directionDot * distanceError
-                //float velocity = pow(directionDot, curveTightness) * targetDistance; //  higher = higher error when in the right direction (will turn more before moving forward);
-                //velocity = clamp(velocity * 10, -followVelocity, followVelocity);
-                
-                RobusMovement::setVelocity(velocity);
-                RobusMovement::setAngularVelocity(clamp(angularVelocity, -0.5, 0.5));
-            } else {
-                RobusMovement::stop();
+        if (fixedRate) {
+            return;
+        }
+
+        PROFILER_SCOPE(PROFILER_POSITION_UPDATE);
+        unsigned long time = timeSource();
+        float dt = updated ? (time - lastUpdateTime) / 1000000.0 : 0;
+        lastUpdateTime = time;
+        updated = true;
+
+        UpdateInputs inputs;
+        readInputs(time, inputs);
+        tick(inputs, dt);
+    }
+
+    /**
+     * @brief Run one update of the fixed-rate mode and record its timing.
+     *
+     * Called by the Timer5 interrupt. The odometry uses the nominal period as dt, so a late
+     * interrupt only shows up in the statistics. The host simulation calls it directly.
+     */
+    void fixedRateUpdate() {
+        PROFILER_SCOPE(PROFILER_POSITION_UPDATE);
+        unsigned long time = timeSource();
+        unsigned long period = 1000000UL / fixedRateFrequency;
+
+        if (updated) {
+            unsigned long interval = time - lastUpdateTime;
+            unsigned long jitter = interval > period ? interval - period : period - interval;
+            if (loopStatistics.updates == 0 || interval < loopStatistics.minInterval) {
+                loopStatistics.minInterval = interval;
+            }
+            if (interval > loopStatistics.maxInterval) {
+                loopStatistics.maxInterval = interval;
+            }
+            if (jitter > loopStatistics.maxJitter) {
+                loopStatistics.maxJitter = jitter;
             }
         }
-        
-        RobusMovement::update();
+        lastUpdateTime = time;
+        updated = true;
+
+        UpdateInputs inputs;
+        readInputs(time, inputs);
+        tick(inputs, period / 1000000.0);
+
+        unsigned long execution = timeSource() - time;
+        if (execution > loopStatistics.maxExecutionTime) {
+            loopStatistics.maxExecutionTime = execution;
+        }
+        if (execution > period) {
+            loopStatistics.overruns++;
+        }
+        loopStatistics.updates++;
+    }
+
+    /**
+     * @brief Body of the Timer5 compare B interrupt of the fixed-rate mode.
+     *
+     * Interrupts are enabled again during the update so micros(), the serial ports and the other
+     * libraries keep working. An interrupt that fires while the previous update still runs is
+     * dropped and counted as an overrun.
+     */
+    void fixedRateInterrupt() {
+        if (fixedRateBusy) {
+            loopStatistics.overruns++;
+            return;
+        }
+        fixedRateBusy = true;
+        interrupts();
+        fixedRateUpdate();
+        noInterrupts();
+        fixedRateBusy = false;
+    }
+
+    /**
+     * @brief Run the odometry and the target follower from a hardware timer at a fixed rate.
+     *
+     * Uses Timer5 running free at clk/8 with its compare B interrupt, so update() calls from
+     * loop() are ignored until stopFixedRate(). Getters and setters can still be used from loop().
+     * Timer1 belongs to the servos, which reset it every refresh. Timer5 only drives pins 44 to 46,
+     * away from the motor PWM on Timer3 and Timer4, and the IR receiver shares it on compare A
+     * without resetting it. Sending IR reconfigures Timer5 and stops the fixed-rate updates.
+     *
+     * @param frequency The update rate in Hz, in the range [31, 10000].
+     */
+    void startFixedRate(uint16_t frequency) {
+        fixedRateFrequency = constrain(frequency, 31, 10000);
+        fixedRateTicks = TIMER5_TICKS_PER_SECOND / fixedRateFrequency;
+        resetLoopStatistics();
+
+#ifdef __AVR__
+        // The update reads the encoders over SPI with interrupts enabled, a transaction of loop() must not be cut
+        SPI.usingInterrupt(255);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            // Keep the timer if it already counts free at clk/8 (IR receiver, encoder sampler)
+            if ((TCCR5A & (_BV(WGM51) | _BV(WGM50))) || (TCCR5B & 0x1F) != _BV(CS51)) {
+                TCCR5A = 0;
+                TCCR5B = _BV(CS51);
+            }
+            OCR5B = TCNT5 + fixedRateTicks;
+            TIFR5 = _BV(OCF5B);
+            TIMSK5 |= _BV(OCIE5B);
+        }
+#endif
+        fixedRate = true;
+    }
+
+    /**
+     * @brief Stop the fixed-rate mode, update() runs the updates again.
+     */
+    void stopFixedRate() {
+#ifdef __AVR__
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            TIMSK5 &= ~_BV(OCIE5B);
+        }
+#endif
+        fixedRate = false;
+    }
+
+    /**
+     * @brief Check if the updates run from the timer interrupt.
+     * @return true if the fixed-rate mode is running; otherwise, false.
+     */
+    bool isFixedRate() {
+        return fixedRate;
+    }
+
+    /**
+     * @brief Get the timing statistics of the fixed-rate mode.
+     * @return The statistics since the last reset.
+     */
+    LoopStatistics getLoopStatistics() {
+        LoopStatistics statistics;
+        POSITION_ATOMIC {
+            statistics = loopStatistics;
+        }
+        return statistics;
+    }
+
+    /**
+     * @brief Reset the timing statistics of the fixed-rate mode.
+     */
+    void resetLoopStatistics() {
+        POSITION_ATOMIC {
+            loopStatistics = LoopStatistics();
+        }
     }
 
     /**
-     * @brief Get the current orientation of the robot.
+     * @brief Get the orientation of the robot at the last update.
      * @return The orientation angle of the robot in radians.
      */
     float getOrientation() {
-        return RobusMovement::computeOrientation();
+        float orientation;
+        POSITION_ATOMIC {
+            orientation = snapshot.orientation;
+        }
+        return orientation;
     }
 
     /**
@@ -105,7 +391,40 @@ namespace RobusPosition
      * @return The current position of the robot as a Vector.
      */
     Vector getPosition() {
-        return position;
+        Vector current;
+        POSITION_ATOMIC {
+            current = Vector(snapshot.x, snapshot.y);
+        }
+        return current;
+    }
+
+    /**
+     * @brief Get the pose snapshot taken by the last update.
+     *
+     * Holds the position, orientation, its cosine and sine, the velocities and the timestamp,
+     * computed once per update. The generation changes when the position or the orientation does,
+     * the velocities and the timestamp alone do not change it.
+     *
+     * @return The pose snapshot.
+     */
+    PoseSnapshot getPoseSnapshot() {
+        PoseSnapshot copy;
+        POSITION_ATOMIC {
+            copy = snapshot;
+        }
+        return copy;
+    }
+
+    /**
+     * @brief Get the generation of the pose snapshot.
+     * @return A counter incremented every time the position or the orientation changes.
+     */
+    uint32_t getPoseGeneration() {
+        uint32_t generation;
+        POSITION_ATOMIC {
+            generation = snapshot.generation;
+        }
+        return generation;
     }
 
     /**
@@ -114,10 +433,45 @@ namespace RobusPosition
      * @param y The Y-coordinate of the new position.
      */
     void setPosition(float x, float y) {
-        position.x = x;
-        position.y = y;
+        POSITION_ATOMIC {
+            odometry.setPosition(PositionScalar(x), PositionScalar(y));
+            snapshot.x = x;
+            snapshot.y = y;
+            snapshot.generation++;
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+            poseHistory.clear();
+#endif
+        }
     }
 
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+    /**
+     * @brief Get the pose the robot had at a given time.
+     *
+     * Useful to match a sensor reading with the pose the robot had when the measure started.
+     * The pose is interpolated between the two closest updates.
+     *
+     * @param time The time in microseconds, from the clock set with setClock().
+     * @param pose Receives the pose of the robot.
+     * @return false if the pose history does not reach back to that time.
+     */
+    bool getPoseAt(unsigned long time, Pose &pose) {
+        bool held = holdFixedRate();
+        bool found = poseHistory.getPoseAt(time, pose);
+        releaseFixedRate(held);
+        return found;
+    }
+
+    /**
+     * @brief Remove all the poses from the pose history.
+     */
+    void clearPoseHistory() {
+        POSITION_ATOMIC {
+            poseHistory.clear();
+        }
+    }
+#endif
+
     /**
      * @brief Set the position of the robot to the specified Vector.
      * @param position The new position of the robot.
@@ -127,6 +481,10 @@ namespace RobusPosition
     }
 
     Vector getTarget() {
+        Vector target;
+        POSITION_ATOMIC {
+            target = Vector(follower.getTargetX(), follower.getTargetY());
+        }
         return target;
     }
 
@@ -136,8 +494,9 @@ namespace RobusPosition
      * @param y The Y-coordinate of the target position.
      */
     void setTarget(float x, float y) {
-        target.x = x;
-        target.y = y;
+        POSITION_ATOMIC {
+            follower.setTarget(x, y);
+        }
     }
 
     /**
@@ -148,12 +507,85 @@ namespace RobusPosition
         setTarget(position.x, position.y);
     }
 
+    /**
+     * @brief Append a waypoint to the path to follow.
+     *
+     * While following, the robot blends through the waypoints with a pure pursuit controller and
+     * only stops on the last one. The path starts from the robot position if the queue was empty.
+     *
+     * @param x The X-coordinate of the waypoint.
+     * @param y The Y-coordinate of the waypoint.
+     * @return false if the waypoint queue is full.
+     */
+    bool addWaypoint(float x, float y) {
+        bool added;
+        POSITION_ATOMIC {
+            added = follower.addWaypoint(x, y, snapshot.x, snapshot.y);
+        }
+        return added;
+    }
+
+    /**
+     * @brief Append a waypoint to the path to follow using a Vector.
+     * @param waypoint The waypoint.
+     * @return false if the waypoint queue is full.
+     */
+    bool addWaypoint(Vector waypoint) {
+        return addWaypoint(waypoint.x, waypoint.y);
+    }
+
+    /**
+     * @brief Remove all the waypoints and reset the progress.
+     */
+    void clearWaypoints() {
+        POSITION_ATOMIC {
+            follower.clearWaypoints();
+        }
+#ifndef ROBUS_POSITION_NO_MAP
+        planActive = false;
+#endif
+    }
+
+    /**
+     * @brief Get the number of waypoints left to reach.
+     * @return The number of waypoints in the queue.
+     */
+    uint8_t getWaypointCount() {
+        return follower.getWaypointCount();
+    }
+
+    /**
+     * @brief Get the number of waypoints reached since the last clearWaypoints().
+     * @return The number of waypoints reached.
+     */
+    uint16_t getCompletedWaypoints() {
+        return follower.getCompletedWaypoints();
+    }
+
+    /**
+     * @brief Set the distance ahead of the robot, along the path, that the waypoint follower aims at.
+     * @param distance The lookahead distance.
+     */
+    void setLookaheadDistance(float distance) {
+        POSITION_ATOMIC {
+            follower.setLookaheadDistance(distance);
+        }
+    }
+
+    /**
+     * @brief Get the distance ahead of the robot that the waypoint follower aims at.
+     * @return The lookahead distance.
+     */
+    float getLookaheadDistance() {
+        return follower.getLookaheadDistance();
+    }
+
     /**
      * @brief Check if the robot is currently following a target.
      * @return true if the robot is following a target; otherwise, false.
      */
     bool isFollowingTarget() {
-        return followingTarget;
+        return follower.isFollowing();
     }
 
     /**
@@ -161,23 +593,27 @@ namespace RobusPosition
      * @param followingTarget true to make the robot follow a target; false to stop following.
      */
     void setFollowingTarget(bool followingTarget) {
-        followingTarget = followingTarget;
+        POSITION_ATOMIC {
+            follower.setFollowing(followingTarget);
+        }
     }
 
     /**
      * @brief Start following the target by setting the following state to true.
      */
     void startFollowingTarget() {
-        followingTarget = true;
-        //setFollowingTarget(true);
+        POSITION_ATOMIC {
+            follower.start(RobusMovement::getVelocity());
+        }
     }
 
     /**
      * @brief Stop following the target by setting the following state to false.
      */
     void stopFollowingTarget() {
-        followingTarget = false;
-        //setFollowingTarget(false);
+        POSITION_ATOMIC {
+            follower.stop();
+        }
     }
 
     /**
@@ -185,7 +621,9 @@ namespace RobusPosition
      * @param scale The scale factor for the angular velocity.
      */
     void setFollowAngularVelocityScale(float scale) {
-        followAngularVelocityScale = scale;
+        POSITION_ATOMIC {
+            follower.setAngularVelocityScale(scale);
+        }
     }
 
     /**
@@ -193,15 +631,68 @@ namespace RobusPosition
      * @param velocity The velocity at which the robot follows the target.
      */
     void setFollowVelocity(float velocity) {
-        followVelocity = velocity;
+        POSITION_ATOMIC {
+            follower.setVelocity(velocity);
+        }
     }
 
     /**
      * @brief Set the tightness of the curve when following a target.
+     *
+     * Rebuilds the speed curve table, 65 float cos() and pow() or a few tens of milliseconds on the
+     * Mega, so call it during setup rather than every loop. The same tightness again costs nothing.
+     *
      * @param tightness The tightness of the curve, affecting the robot's path.
      */
     void setCurveTightness(float tightness) {
-        curveTightness = tightness;
+        if (tightness == follower.getCurveTightness()) {
+            return;
+        }
+        // Built before holding the fixed-rate updates, they only wait for the copy.
+        SpeedCurve curve(tightness);
+        bool held = holdFixedRate();
+        follower.setCurveTightness(tightness, curve);
+        releaseFixedRate(held);
+    }
+
+    /**
+     * @brief Set the limits of the velocity profile used when following a target.
+     *
+     * The velocity ramps up to the cruise speed within the acceleration and jerk limits, and brakes
+     * within the deceleration limit so the robot stops on the target. Zero disables a limit.
+     *
+     * @param acceleration Maximum acceleration when speeding up, per second.
+     * @param deceleration Maximum deceleration when slowing down, per second.
+     * @param jerk Maximum change of acceleration, per second.
+     */
+    void setFollowProfile(float acceleration, float deceleration, float jerk) {
+        POSITION_ATOMIC {
+            follower.setProfile(acceleration, deceleration, jerk);
+        }
+    }
+
+    /**
+     * @brief Get the maximum acceleration when following a target.
+     * @return The maximum acceleration, zero when unlimited.
+     */
+    float getFollowAcceleration() {
+        return follower.getAcceleration();
+    }
+
+    /**
+     * @brief Get the maximum deceleration when following a target.
+     * @return The maximum deceleration, zero when unlimited.
+     */
+    float getFollowDeceleration() {
+        return follower.getDeceleration();
+    }
+
+    /**
+     * @brief Get the maximum jerk when following a target.
+     * @return The maximum jerk, zero when unlimited.
+     */
+    float getFollowJerk() {
+        return follower.getJerk();
     }
 
     /**
@@ -209,7 +700,7 @@ namespace RobusPosition
      * @return The current angular velocity scale factor.
      */
     float getFollowAngularVelocityScale() {
-        return followAngularVelocityScale;
+        return follower.getAngularVelocityScale();
     }
 
     /**
@@ -217,7 +708,7 @@ namespace RobusPosition
      * @return The current target following velocity.
      */
     float getFollowVelocity() {
-        return followVelocity;
+        return follower.getVelocity();
     }
 
      /**
@@ -225,7 +716,290 @@ namespace RobusPosition
      * @return The current curve tightness value.
      */
     float getCurveTightness() {
-        return curveTightness;
+        return follower.getCurveTightness();
+    }
+
+    /**
+     * @brief Get where the odometry reads the robot displacement from.
+     * @return The current odometry source.
+     */
+    OdometrySource getOdometrySource() {
+        return odometrySource;
+    }
+
+    /**
+     * @brief Set where the odometry reads the robot displacement from.
+     *
+     * ENCODER_TICKS integrates the raw tick deltas of ENCODER_ReadBoth() instead of the velocities
+     * estimated by RobusMovement. The heading then comes from the tick difference between the
+     * wheels, starting from the current orientation.
+     *
+     * @param source The odometry source.
+     */
+    void setOdometrySource(OdometrySource source) {
+        // Held rather than atomic, the counters are read over SPI.
+        bool held = holdFixedRate();
+        if (source == ENCODER_TICKS && odometrySource != ENCODER_TICKS) {
+            EncoderCounts counts = ENCODER_ReadBoth();
+            odometry.resetTicks(counts.left, counts.right, readOrientation() - orientationCorrection);
+        }
+        odometrySource = source;
+        releaseFixedRate(held);
+    }
+
+    /**
+     * @brief Set the wheel geometry used by the ENCODER_TICKS odometry.
+     * @param distance The distance travelled by a wheel for one encoder tick, in position units.
+     * @param width The distance between the two wheels, in position units.
+     */
+    void setEncoderGeometry(float distance, float width) {
+        POSITION_ATOMIC {
+            odometry.setEncoderGeometry(distance, width, readOrientation() - orientationCorrection);
+        }
+    }
+
+    /**
+     * @brief Get the distance travelled by a wheel for one encoder tick.
+     * @return The distance per tick, in position units.
+     */
+    float getDistancePerTick() {
+        return odometry.getDistancePerTick();
+    }
+
+    /**
+     * @brief Get the distance between the two wheels.
+     * @return The track width, in position units.
+     */
+    float getTrackWidth() {
+        return odometry.getTrackWidth();
+    }
+
+    /**
+     * @brief Set the wheel corrections used by the ENCODER_TICKS odometry.
+     * @param calibration The wheel and track width scales.
+     */
+    void setWheelCalibration(WheelCalibration calibration) {
+        POSITION_ATOMIC {
+            odometry.setCalibration(calibration, readOrientation() - orientationCorrection);
+        }
+    }
+
+    /**
+     * @brief Get the wheel corrections used by the ENCODER_TICKS odometry.
+     * @return The wheel and track width scales.
+     */
+    WheelCalibration getWheelCalibration() {
+        return odometry.getCalibration();
+    }
+
+    /**
+     * @brief Set the side of the calibration square and forget the measured runs.
+     * @param side The side of the square, in position units.
+     */
+    void setCalibrationSquare(float side) {
+        umbmark.reset(side);
+    }
+
+    /**
+     * @brief Start driving the UMBmark calibration square from the current pose.
+     *
+     * The robot stops at each corner and turns in place toward the next one, using the
+     * ENCODER_TICKS odometry alone. Once it is back (isCalibrationRunning() returns false),
+     * measure where it really stopped and pass it to addCalibrationRun().
+     *
+     * @param clockwise Whether the square turns right.
+     * @return false if the odometry source is not ENCODER_TICKS.
+     */
+    bool startCalibrationRun(bool clockwise) {
+        if (odometrySource != ENCODER_TICKS) {
+            return false;
+        }
+        PoseSnapshot pose = getPoseSnapshot();
+        POSITION_ATOMIC {
+            follower.clearWaypoints();
+            calibrationStart = Pose(pose.x, pose.y, pose.orientation);
+            calibrationClockwise = clockwise;
+            calibrationLeg = 0;
+            advanceCalibrationRun();
+            follower.start(RobusMovement::getVelocity());
+        }
+#ifndef ROBUS_POSITION_NO_MAP
+        planActive = false;
+#endif
+        return true;
+    }
+
+    /**
+     * @brief Check if a calibration square is being driven.
+     * @return true until the robot is back on the start of the square.
+     */
+    bool isCalibrationRunning() {
+        return calibrationLeg != 0;
+    }
+
+    /**
+     * @brief Add the measured end error of a calibration run.
+     * @param clockwise Whether the square turned right.
+     * @param errorX The real end position minus the start, along the first leg.
+     * @param errorY The real end position minus the start, to the left of the first leg.
+     */
+    void addCalibrationRun(bool clockwise, float errorX, float errorY) {
+        umbmark.addRun(clockwise, errorX, errorY);
+    }
+
+    /**
+     * @brief Compute the wheel corrections from the measured runs, apply them and save the parameters to EEPROM.
+     *
+     * The corrections add up with the calibration used during the runs, so the procedure can be
+     * repeated to refine it. The measured runs are forgotten.
+     *
+     * @return false if both directions do not have a run, or the errors are too large.
+     */
+    bool applyCalibration() {
+        WheelCalibration current = odometry.getCalibration();
+        WheelCalibration correction;
+        if (!umbmark.compute(odometry.getTrackWidth() * current.trackScale, correction)) {
+            return false;
+        }
+
+        setWheelCalibration(WheelCalibration(current.leftScale * correction.leftScale,
+                                             current.rightScale * correction.rightScale,
+                                             current.trackScale * correction.trackScale));
+        saveParameters();
+        umbmark.reset(umbmark.getSide());
+        return true;
+    }
+
+    /**
+     * @brief Get the follow settings, the encoder geometry and the wheel corrections.
+     * @return The settings kept by saveParameters().
+     */
+    StoredParameters getParameters() {
+        StoredParameters parameters;
+        parameters.followVelocity = follower.getVelocity();
+        parameters.followAngularVelocityScale = follower.getAngularVelocityScale();
+        parameters.curveTightness = follower.getCurveTightness();
+        parameters.lookaheadDistance = follower.getLookaheadDistance();
+        parameters.acceleration = follower.getAcceleration();
+        parameters.deceleration = follower.getDeceleration();
+        parameters.jerk = follower.getJerk();
+        parameters.distancePerTick = odometry.getDistancePerTick();
+        parameters.trackWidth = odometry.getTrackWidth();
+        parameters.calibration = odometry.getCalibration();
+        parameters.inverted = inverted;
+        return parameters;
+    }
+
+    /**
+     * @brief Set the follow settings, the encoder geometry and the wheel corrections at once.
+     * @param parameters The settings, e.g. from getParameters().
+     */
+    void setParameters(const StoredParameters &parameters) {
+        setFollowVelocity(parameters.followVelocity);
+        setFollowAngularVelocityScale(parameters.followAngularVelocityScale);
+        setCurveTightness(parameters.curveTightness);
+        setLookaheadDistance(parameters.lookaheadDistance);
+        setFollowProfile(parameters.acceleration, parameters.deceleration, parameters.jerk);
+        setEncoderGeometry(parameters.distancePerTick, parameters.trackWidth);
+        setWheelCalibration(parameters.calibration);
+        setInverted(parameters.inverted);
+    }
+
+    /**
+     * @brief Save the follow settings, the encoder geometry and the wheel corrections to EEPROM.
+     */
+    void saveParameters() {
+        parameterStore.saveParameters(getParameters());
+    }
+
+    /**
+     * @brief Restore the settings saved by saveParameters(), typically from setup().
+     * @return false if the EEPROM holds no valid parameters of this version; the settings are unchanged.
+     */
+    bool loadParameters() {
+        StoredParameters parameters;
+        if (!parameterStore.loadParameters(parameters)) {
+            return false;
+        }
+        setParameters(parameters);
+        return true;
+    }
+
+    /**
+     * @brief Save the current pose to EEPROM, in the next wear-levelling slot.
+     *
+     * Takes about 50 ms while the EEPROM is written, call it when the robot is stopped.
+     */
+    void savePose() {
+        PoseSnapshot pose = getPoseSnapshot();
+        parameterStore.savePose(Pose(pose.x, pose.y, pose.orientation));
+    }
+
+    /**
+     * @brief Restore the pose saved by savePose(), typically from setup().
+     * @return false if no pose is saved; the pose is unchanged.
+     */
+    bool loadPose() {
+        Pose pose;
+        if (!parameterStore.loadPose(pose)) {
+            return false;
+        }
+        POSITION_ATOMIC {
+            odometry.setPosition(PositionScalar(pose.x), PositionScalar(pose.y));
+            orientationCorrection += pose.orientation - readOrientation();
+            snapshot.x = pose.x;
+            snapshot.y = pose.y;
+            snapshot.orientation = pose.orientation;
+            snapshot.cosOrientation = positionCos(pose.orientation);
+            snapshot.sinOrientation = positionSin(pose.orientation);
+            snapshot.generation++;
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+            poseHistory.clear();
+#endif
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the method used to integrate the robot displacement.
+     * @return The current integration method.
+     */
+    Integrator getIntegrator() {
+        return odometry.getIntegrator();
+    }
+
+    /**
+     * @brief Set the method used to integrate the robot displacement.
+     *
+     * ARC is exact as long as the velocity and angular velocity are constant during an update,
+     * so one step per update is enough. EULER keeps the INTEGRATION_ITERATION sub-steps.
+     * Has no effect when ROBUS_POSITION_INTEGRATOR fixes the integrator at compile time.
+     *
+     * @param method The integration method.
+     */
+    void setIntegrator(Integrator method) {
+        POSITION_ATOMIC {
+            odometry.setIntegrator(method);
+        }
+    }
+
+    /**
+     * @brief Set the clock used to timestamp the updates.
+     *
+     * Defaults to micros(). A simulation can inject its own clock to run faster than real time.
+     *
+     * @param clock A function returning the time in microseconds.
+     */
+    void setClock(unsigned long (*clock)()) {
+        timeSource = clock;
+    }
+
+    /**
+     * @brief Get the time from the clock used to timestamp the updates.
+     * @return The time in microseconds.
+     */
+    unsigned long getTime() {
+        return timeSource();
     }
 
      /**
@@ -241,17 +1015,488 @@ namespace RobusPosition
      * @param invert if the robot direction will be inverted or not.
      */
     void setInverted(bool invert) {
-        inverted = invert;
+        POSITION_ATOMIC {
+            inverted = invert;
+            follower.setInverted(invert);
+        }
+    }
+
+    /**
+     * @brief Enable the extended Kalman filter that corrects the odometry with range measures.
+     *
+     * The covariance starts from the values given to resetPoseFilter(), zero by default.
+     *
+     * @param enabled true to enable the filter; false to let the odometry run alone.
+     */
+    void setPoseFilterEnabled(bool enabled) {
+        poseFilterEnabled = enabled;
+    }
+
+    bool isPoseFilterEnabled() {
+        return poseFilterEnabled;
+    }
+
+    /**
+     * @brief Set the uncertainty of the current pose.
+     * @param positionVariance Variance of both coordinates.
+     * @param orientationVariance Variance of the orientation, in radians squared.
+     */
+    void resetPoseFilter(float positionVariance, float orientationVariance) {
+        bool held = holdFixedRate();
+        poseFilter.reset(positionVariance, orientationVariance);
+        releaseFixedRate(held);
+    }
+
+    /**
+     * @brief Set how fast the odometry error grows.
+     * @param distance Variance of the travelled distance per unit travelled.
+     * @param rotation Variance of the rotation per radian turned.
+     * @param drift Variance of the rotation per unit travelled.
+     */
+    void setOdometryNoise(float distance, float rotation, float drift) {
+        bool held = holdFixedRate();
+        poseFilter.setNoise(distance, rotation, drift);
+        releaseFixedRate(held);
     }
 
+    /**
+     * @brief Get the covariance of the (x, y, orientation) pose estimated by the filter.
+     * @return The 3x3 covariance matrix.
+     */
+    Matrix<3, 3> getPoseCovariance() {
+        bool held = holdFixedRate();
+        Matrix<3, 3> covariance = poseFilter.getCovariance();
+        releaseFixedRate(held);
+        return covariance;
+    }
+
+    /**
+     * @brief Add a wall the range sensors can see to the map of the filter.
+     * @return false if the map already holds POSE_FILTER_WALL_COUNT walls.
+     */
+    bool addWall(float x1, float y1, float x2, float y2) {
+        bool held = holdFixedRate();
+        bool added = poseFilter.addWall(Wall(x1, y1, x2, y2));
+        releaseFixedRate(held);
+        return added;
+    }
+
+    void clearWalls() {
+        bool held = holdFixedRate();
+        poseFilter.clearWalls();
+        releaseFixedRate(held);
+    }
+
+    /**
+     * @brief Correct the pose with a range measured to one of the walls.
+     * @param sensor The sensor that took the measure.
+     * @param range The measured range, in position units.
+     * @return true if the filter is enabled and the measure was used; otherwise, false.
+     */
+    bool correctRange(const RangeSensor &sensor, float range) {
+        if (!poseFilterEnabled) {
+            return false;
+        }
+
+        bool held = holdFixedRate();
+        Pose pose = Pose(snapshot.x, snapshot.y, snapshot.orientation);
+        bool accepted = poseFilter.correct(pose, sensor, range);
+        if (accepted) {
+            POSITION_ATOMIC {
+                odometry.setPosition(PositionScalar(pose.x), PositionScalar(pose.y));
+                orientationCorrection += pose.orientation - snapshot.orientation;
+                snapshot.x = pose.x;
+                snapshot.y = pose.y;
+                snapshot.orientation = pose.orientation;
+                snapshot.cosOrientation = positionCos(pose.orientation);
+                snapshot.sinOrientation = positionSin(pose.orientation);
+                snapshot.generation++;
+            }
+        }
+        releaseFixedRate(held);
+        return accepted;
+    }
+
+    /**
+     * @brief Set where a sonar is mounted, for correctWithSonar().
+     * @param id The sonar, 0 or 1.
+     * @param sensor Its mount, variance and trusted range, in meters.
+     */
+    void setSonarMount(uint8_t id, RangeSensor sensor) {
+        if (id < SONAR_COUNT) {
+            sonarMounts[id] = sensor;
+        }
+    }
+
+    /**
+     * @brief Set where an infrared ranger is mounted, for correctWithIR().
+     * @param id The ranger, in [0, 3].
+     * @param sensor Its mount, variance and trusted range, in meters.
+     */
+    void setIRMount(uint8_t id, RangeSensor sensor) {
+        if (id < IR_COUNT) {
+            irMounts[id] = sensor;
+        }
+    }
+
+    /**
+     * @brief Measure the range with a sonar and correct the pose with it.
+     *
+     * Blocks for the echo, up to about 30 ms.
+     *
+     * @param id The sonar, 0 or 1.
+     * @return true if the measure was used; otherwise, false.
+     */
+    bool correctWithSonar(uint8_t id) {
+        if (id >= SONAR_COUNT || sonarMounts[id].maxRange <= 0) {
+            return false;
+        }
+        // SONAR_GetRange() returns centimeters.
+        return correctRange(sonarMounts[id], SONAR_GetRange(id) / 100.0f);
+    }
+
+    /**
+     * @brief Convert a raw reading of an infrared ranger to a distance.
+     *
+     * Uses the inverse law range = IR_RANGE_NUMERATOR / (raw - IR_RANGE_OFFSET) of the Sharp rangers.
+     *
+     * @param raw The ADC reading from ROBUS_ReadIR().
+     * @return The range in meters, negative when out of the curve.
+     */
+    float irToRange(uint16_t raw) {
+        if (raw <= IR_RANGE_OFFSET) {
+            return -1;
+        }
+        return IR_RANGE_NUMERATOR / (raw - IR_RANGE_OFFSET);
+    }
+
+    /**
+     * @brief Measure the range with an infrared ranger and correct the pose with it.
+     * @param id The ranger, in [0, 3].
+     * @return true if the measure was used; otherwise, false.
+     */
+    bool correctWithIR(uint8_t id) {
+        if (id >= IR_COUNT || irMounts[id].maxRange <= 0) {
+            return false;
+        }
+        return correctRange(irMounts[id], irToRange(ROBUS_ReadIR(id)));
+    }
+
+#ifndef ROBUS_POSITION_NO_MAP
+    /**
+     * @brief Insert a range measure in the occupancy grid, from the current pose.
+     *
+     * A measure beyond the maximum range of the sensor marks the beam free up to that range,
+     * without an obstacle at its end.
+     *
+     * @param sensor The sensor that took the measure.
+     * @param range The measured range, in position units.
+     * @return false if the sensor is disabled or the measure is below its minimum range.
+     */
+    bool mapRange(const RangeSensor &sensor, float range) {
+        if (sensor.maxRange <= 0 || !(range >= sensor.minRange)) {
+            return false;
+        }
+        bool hit = range <= sensor.maxRange;
+        if (!hit) {
+            range = sensor.maxRange;
+        }
+
+        PoseSnapshot pose = getPoseSnapshot();
+        float sensorX = pose.x + pose.cosOrientation * sensor.x - pose.sinOrientation * sensor.y;
+        float sensorY = pose.y + pose.sinOrientation * sensor.x + pose.cosOrientation * sensor.y;
+        float beam = pose.orientation + sensor.angle;
+        occupancyGrid.insertRay(sensorX, sensorY, sensorX + range * positionCos(beam), sensorY + range * positionSin(beam), hit);
+        return true;
+    }
+
+    /**
+     * @brief Measure the range with a sonar and insert it in the occupancy grid.
+     * @param id The sonar, 0 or 1.
+     * @return true if the measure was inserted; otherwise, false.
+     */
+    bool mapWithSonar(uint8_t id) {
+        if (id >= SONAR_COUNT) {
+            return false;
+        }
+        return mapRange(sonarMounts[id], SONAR_GetRange(id) / 100.0f);
+    }
+
+    /**
+     * @brief Measure the range with an infrared ranger and insert it in the occupancy grid.
+     * @param id The ranger, in [0, 3].
+     * @return true if the measure was inserted; otherwise, false.
+     */
+    bool mapWithIR(uint8_t id) {
+        if (id >= IR_COUNT) {
+            return false;
+        }
+        return mapRange(irMounts[id], irToRange(ROBUS_ReadIR(id)));
+    }
+
+    /**
+     * @brief Get the occupancy grid filled by mapRange(), to query or configure it.
+     * @return The occupancy grid.
+     */
+    OccupancyGrid &getOccupancyGrid() {
+        return occupancyGrid;
+    }
+
+    /**
+     * @brief Plan a path around the obstacles of the occupancy grid and follow it.
+     *
+     * The turns of the path replace the waypoints and the robot starts following them. The plan
+     * stays active until the last waypoint is reached or clearWaypoints() is called, so
+     * replanIfBlocked() can route around the obstacles found on the way.
+     *
+     * @param x The X-coordinate of the goal.
+     * @param y The Y-coordinate of the goal.
+     * @return PLAN_FOUND if the robot follows the new path; otherwise, the waypoints are unchanged.
+     */
+    PlanResult planPath(float x, float y) {
+        PoseSnapshot pose = getPoseSnapshot();
+        PlanResult result = planner.plan(occupancyGrid, pose.x, pose.y, x, y);
+        if (result != PLAN_FOUND) {
+            return result;
+        }
+
+        // The whole path is swapped between two updates.
+        bool held = holdFixedRate();
+        follower.clearWaypoints();
+        for (uint8_t i = 0; i < planner.getPathLength(); i++) {
+            float pointX, pointY;
+            planner.getPathPoint(i, pointX, pointY);
+            follower.addWaypoint(pointX, pointY, pose.x, pose.y);
+        }
+        follower.start(RobusMovement::getVelocity());
+        releaseFixedRate(held);
+
+        planActive = true;
+        planGoalX = x;
+        planGoalY = y;
+        return PLAN_FOUND;
+    }
+
+    /**
+     * @brief Check if the robot is following a path from planPath().
+     * @return true while waypoints of the plan remain.
+     */
+    bool isPlanActive() {
+        if (planActive && follower.getWaypointCount() == 0) {
+            planActive = false;
+        }
+        return planActive;
+    }
+
+    /**
+     * @brief Plan again if an obstacle now lies on the rest of the planned path.
+     *
+     * Only the segments left to drive are checked against the occupancy grid, which is much
+     * cheaper than a new search, so it can run after every map update.
+     *
+     * @return true if a new path was planned; false if the path is still clear, if no plan is
+     * active, or if no path remains (the robot stops).
+     */
+    bool replanIfBlocked() {
+        if (!isPlanActive()) {
+            return false;
+        }
+
+        PoseSnapshot pose = getPoseSnapshot();
+        float fromX = pose.x;
+        float fromY = pose.y;
+        bool blocked = false;
+        uint8_t count = follower.getWaypointCount();
+        for (uint8_t i = 0; i < count && !blocked; i++) {
+            float toX, toY;
+            POSITION_ATOMIC {
+                follower.getWaypoint(i, toX, toY);
+            }
+            blocked = planner.isSegmentBlocked(occupancyGrid, fromX, fromY, toX, toY);
+            fromX = toX;
+            fromY = toY;
+        }
+        if (!blocked) {
+            return false;
+        }
+
+        if (planPath(planGoalX, planGoalY) != PLAN_FOUND) {
+            clearWaypoints();
+            stopFollowingTarget();
+            RobusMovement::stop();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Mark an obstacle in the occupancy grid and plan again if it blocks the path.
+     * @param x The X-coordinate of the obstacle.
+     * @param y The Y-coordinate of the obstacle.
+     * @return true if a new path was planned.
+     */
+    bool reportObstacle(float x, float y) {
+        occupancyGrid.markOccupied(x, y);
+        return replanIfBlocked();
+    }
+
+    /**
+     * @brief Mark the obstacle touched by a bumper and plan again if it blocks the path.
+     * @param id The bumper, LEFT, RIGHT, FRONT or REAR.
+     * @return true if a new path was planned.
+     */
+    bool reportBumper(uint8_t id) {
+        float angle;
+        switch (id) {
+            case LEFT: angle = HALF_PI; break;
+            case RIGHT: angle = -HALF_PI; break;
+            case FRONT: angle = 0; break;
+            case REAR: angle = PI; break;
+            default: return false;
+        }
+        PoseSnapshot pose = getPoseSnapshot();
+        float direction = pose.orientation + angle;
+        return reportObstacle(pose.x + BUMPER_DISTANCE * positionCos(direction), pose.y + BUMPER_DISTANCE * positionSin(direction));
+    }
+#endif
+
+#ifdef ROBUS_POSITION_RECORDER
+    /**
+     * @brief Start recording the inputs and results of the updates, forgetting the previous ones.
+     */
+    void startRecording() {
+        POSITION_ATOMIC {
+            recorder.start();
+        }
+    }
+
+    void stopRecording() {
+        POSITION_ATOMIC {
+            recorder.stop();
+        }
+    }
+
+    bool isRecording() {
+        return recorder.isRecording();
+    }
+
+    /**
+     * @brief Get the number of updates recorded, at most RECORDER_SIZE.
+     */
+    uint16_t getRecordCount() {
+        return recorder.getCount();
+    }
+
+    /**
+     * @brief Stop recording and write the recorded updates over Serial, in binary.
+     *
+     * Capture the bytes to a file and give it to the replay mode of the host build.
+     */
+    void dumpRecording() {
+        stopRecording();
+
+        RecordHeader header;
+        header.integrator = odometry.getIntegrator();
+        header.fixedRateFrequency = fixedRate ? fixedRateFrequency : 0;
+        header.count = recorder.getCount();
+        header.parameters = getParameters();
+        uint8_t buffer[RECORDER_HEADER_SIZE > RECORDER_ENTRY_SIZE ? RECORDER_HEADER_SIZE : RECORDER_ENTRY_SIZE];
+        Recorder::encodeHeader(header, buffer);
+        Serial.write(buffer, RECORDER_HEADER_SIZE);
+
+        for (uint16_t i = 0; i < header.count; i++) {
+            Recorder::encodeEntry(recorder.get(i), buffer);
+            Serial.write(buffer, RECORDER_ENTRY_SIZE);
+        }
+        Serial.flush();
+    }
+
+    /**
+     * @brief Put the odometry in the state a recorded update left it, before replaying the next ones.
+     * @param entry The recorded update.
+     */
+    void startReplay(const RecordEntry &entry) {
+        stopFixedRate();
+        follower.clearWaypoints();
+        odometrySource = entry.flags & RecordEntry::ENCODER ? ENCODER_TICKS : MOVEMENT_VELOCITY;
+        odometry.setPosition(PositionScalar(entry.x), PositionScalar(entry.y));
+        if (odometrySource == ENCODER_TICKS) {
+            orientationCorrection = 0;
+            odometry.resetTicks(entry.inputs.encoder.left, entry.inputs.encoder.right, entry.orientation);
+        } else {
+            orientationCorrection = entry.orientation - entry.inputs.orientation;
+        }
+        lastUpdateTime = entry.inputs.time;
+        updated = true;
+    }
+
+    /**
+     * @brief Run an update on recorded readings instead of the hardware.
+     *
+     * The follower aims at the recorded target, the waypoint queue is not replayed.
+     *
+     * @param entry The recorded update.
+     * @param dt Elapsed time since the previous entry, in seconds, as the recorded update computed it.
+     */
+    void replayUpdate(const RecordEntry &entry, float dt) {
+        follower.setFollowing(entry.flags & RecordEntry::FOLLOWING);
+        follower.setTarget(entry.targetX, entry.targetY);
+        lastUpdateTime = entry.inputs.time;
+        tick(entry.inputs, dt);
+    }
+#endif
+
     namespace {
-        Vector position = Vector(); /**< The current position of the robot. */
-        Vector target = Vector(); /**< The target position for the robot to follow. */
-        bool followingTarget = false; /**< Flag indicating whether the robot is following a target. */
-        //5, 10, 5
-        float followAngularVelocityScale = 3.0; /**< Scale factor for angular velocity when following a target. */
-        float followVelocity = 3; /**< Velocity at which the robot follows a target. */
-        float curveTightness = 50; /**< Tightness of the curve when following a target. */
+        PositionOdometry odometry = PositionOdometry(); /**< Position integrated by update(). */
+        PositionFollower follower = PositionFollower(); /**< Target and waypoint follower driven by update(). */
         bool inverted = false;
+        OdometrySource odometrySource = MOVEMENT_VELOCITY; /**< Where the odometry reads the robot displacement from. */
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+        PoseHistory poseHistory = PoseHistory(); /**< Timestamped poses of the last updates. */
+#endif
+        unsigned long (*timeSource)() = micros; /**< Clock used to timestamp the updates, in microseconds. */
+        PoseSnapshot snapshot = PoseSnapshot(); /**< Pose computed once by the last update. */
+        unsigned long lastUpdateTime = 0; /**< Timestamp of the last update. */
+        bool updated = false; /**< Flag indicating whether lastUpdateTime holds a real update. */
+        volatile bool fixedRate = false; /**< Flag indicating whether the updates run from the Timer5 interrupt. */
+        volatile bool fixedRateBusy = false; /**< Flag indicating whether a fixed-rate update is running. */
+        uint16_t fixedRateFrequency = 100; /**< Update rate of the fixed-rate mode, in Hz. */
+        uint16_t fixedRateTicks = 20000; /**< Timer5 ticks between two fixed-rate updates. */
+        LoopStatistics loopStatistics = LoopStatistics(); /**< Timing of the fixed-rate updates. */
+        PoseFilter poseFilter = PoseFilter(); /**< Covariance of the pose and map of the walls. */
+        bool poseFilterEnabled = false; /**< Flag indicating whether the updates propagate the covariance. */
+        float orientationCorrection = 0; /**< Orientation added to the odometry heading by the filter. */
+        RangeSensor sonarMounts[SONAR_COUNT]; /**< Mounts of the sonars. */
+        RangeSensor irMounts[IR_COUNT]; /**< Mounts of the infrared rangers. */
+#ifndef ROBUS_POSITION_NO_MAP
+        OccupancyGrid occupancyGrid = OccupancyGrid(); /**< Obstacles seen by the range sensors. */
+#endif
+        Umbmark umbmark = Umbmark(); /**< Measured runs of the calibration square. */
+        uint8_t calibrationLeg = 0; /**< Leg of the calibration square being driven, 0 when idle. */
+        bool calibrationClockwise = false; /**< Flag indicating whether the calibration square turns right. */
+        Pose calibrationStart = Pose(); /**< Pose at the start of the calibration square. */
+        ParameterStore parameterStore = ParameterStore(); /**< Parameters and pose kept in EEPROM. */
+#ifdef ROBUS_POSITION_RECORDER
+        Recorder recorder = Recorder(); /**< Last updates, for a replay on the host. */
+#endif
+#ifndef ROBUS_POSITION_NO_MAP
+        GridPlanner planner = GridPlanner(); /**< Path search on occupancyGrid, zero-initialized. */
+        bool planActive = false; /**< Flag indicating whether the waypoints come from planPath(). */
+        float planGoalX = 0; /**< Goal of the active plan. */
+        float planGoalY = 0;
+#endif
     }
 }
+
+#ifdef __AVR__
+ISR(TIMER5_COMPB_vect) {
+    // Schedule from the previous compare value so the period does not drift with the latency.
+    OCR5B += RobusPosition::fixedRateTicks;
+    // Past the counter already, the next compare would wait a whole wrap of Timer5: count it late and resync.
+    if ((int16_t) (OCR5B - TCNT5) <= 0) {
+        OCR5B = TCNT5 + RobusPosition::fixedRateTicks;
+        RobusPosition::loopStatistics.overruns++;
+    }
+    RobusPosition::fixedRateInterrupt();
+}
+#endif
@@ -3,10 +3,60 @@
 
 #include <RobusPosition.h> 
 #include <RobusMovement.h>
+#include <LibRobus.h>
 #include <mathX.h>
+#include "FixedPoint.h"
+#include "Integration.h"
+#include "PoseHistory.h"
+#include "WaypointQueue.h"
+#include "MotionProfile.h"
+#include "SpeedCurve.h"
+#include "Calibration.h"
+#include "Odometry.h"
+#include "ParameterStore.h"
+#include "Recorder.h"
+#include "Follower.h"
+#include "Matrix.h"
+#include "PoseFilter.h"
+#include "OccupancyGrid.h"
+#include "GridPlanner.h"
+
+#ifndef ROBUS_POSITION_INTEGRATOR
+#define ROBUS_POSITION_INTEGRATOR SELECTED // Or EULER, MIDPOINT, RK4, ARC to compile only that one
+#endif
+
+#define SONAR_COUNT 2
+#define IR_COUNT 4
+
+#ifndef IR_RANGE_NUMERATOR
+#define IR_RANGE_NUMERATOR 48.0f // Sharp GP2Y0A21 on a 10-bit ADC at 5 V, in meters
+#endif
+
+#ifndef IR_RANGE_OFFSET
+#define IR_RANGE_OFFSET 20
+#endif
+
+#ifndef BUMPER_DISTANCE
+#define BUMPER_DISTANCE 0.12f // From the center of the robot to its bumpers, in meters
+#endif
+
+// The state of RobusPosition takes about 2.4 KB of SRAM in every sketch, its objects are constructed
+// at startup so the linker keeps them even when unused. Two build flags remove the largest ones:
+// ROBUS_POSITION_NO_MAP the occupancy grid (1036 bytes), mapRange() and planPath(),
+// ROBUS_POSITION_NO_POSE_HISTORY the history of getPoseAt() (514 bytes).
 
 namespace RobusPosition
 {   
+#ifdef ROBUS_POSITION_FIXED_POINT
+    typedef FixedPoint::Fixed PositionScalar;
+#else
+    typedef float PositionScalar;
+#endif
+
+    // Types of the odometry and follower run by update(), host tools make their own instances.
+    typedef Odometry<PositionScalar, ROBUS_POSITION_INTEGRATOR> PositionOdometry;
+    typedef Follower<PositionScalar> PositionFollower;
+
     /**
      * @brief Vector structure to represent position and direction.
      */
@@ -19,18 +69,81 @@ namespace RobusPosition
         float y;
     };
 
+    /**
+     * @brief Pose of the robot computed once per update.
+     */
+    struct PoseSnapshot {
+        PoseSnapshot() : x(0), y(0), orientation(0), cosOrientation(1), sinOrientation(0),
+                         velocity(0), angularVelocity(0), time(0), generation(0) {}
+        float x;
+        float y;
+        float orientation;      /**< Orientation in radians. */
+        float cosOrientation;   /**< Cosine of the orientation. */
+        float sinOrientation;   /**< Sine of the orientation. */
+        float velocity;         /**< Linear velocity over the last update. */
+        float angularVelocity;  /**< Angular velocity over the last update, in radians per second. */
+        unsigned long time;     /**< Timestamp of the update, in microseconds. */
+        uint32_t generation;    /**< Incremented when x, y or the orientation change. */
+    };
+
+    /**
+     * @brief Where the odometry reads the robot displacement from.
+     */
+    enum OdometrySource {
+        MOVEMENT_VELOCITY,  /**< Velocities estimated by RobusMovement. */
+        ENCODER_TICKS       /**< Raw encoder tick deltas. */
+    };
+
+    /**
+     * @brief Timing of the fixed-rate updates, in microseconds.
+     */
+    struct LoopStatistics {
+        LoopStatistics() : updates(0), overruns(0), minInterval(0), maxInterval(0),
+                           maxJitter(0), maxExecutionTime(0) {}
+        uint32_t updates;               /**< Updates run since the last reset. */
+        uint16_t overruns;              /**< Updates longer than the period, skipped while the previous one ran, or late past their compare. */
+        unsigned long minInterval;      /**< Shortest time between two updates. */
+        unsigned long maxInterval;      /**< Longest time between two updates. */
+        unsigned long maxJitter;        /**< Largest difference between an interval and the period. */
+        unsigned long maxExecutionTime; /**< Longest update. */
+    };
+
     void update();
 
+    void startFixedRate(uint16_t frequency);
+    void stopFixedRate();
+    bool isFixedRate();
+    void fixedRateUpdate();
+    void fixedRateInterrupt();
+    LoopStatistics getLoopStatistics();
+    void resetLoopStatistics();
+
     float getOrientation();
 
     Vector getPosition();
+    PoseSnapshot getPoseSnapshot();
+    uint32_t getPoseGeneration();
     void setPosition(float x, float y);
     void setPosition(Vector position);
 
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+    bool getPoseAt(unsigned long time, Pose &pose);
+    void clearPoseHistory();
+#endif
+
     Vector getTarget();
     void setTarget(float x, float y);
     void setTarget(Vector position);
 
+    bool addWaypoint(float x, float y);
+    bool addWaypoint(Vector waypoint);
+    void clearWaypoints();
+    uint8_t getWaypointCount();
+    uint16_t getCompletedWaypoints();
+
+    void setLookaheadDistance(float distance);
+    float getLookaheadDistance();
+
     bool isFollowingTarget();
     void setFollowingTarget(bool followingTarget);
 
@@ -41,23 +154,126 @@ namespace RobusPosition
     void setFollowVelocity(float velocity);
     void setCurveTightness(float tightness);
 
+    void setFollowProfile(float acceleration, float deceleration, float jerk);
+    float getFollowAcceleration();
+    float getFollowDeceleration();
+    float getFollowJerk();
+
     float getFollowAngularVelocityScale();
     float getFollowVelocity();
     float getCurveTightness();
 
+    OdometrySource getOdometrySource();
+    void setOdometrySource(OdometrySource source);
+
+    void setEncoderGeometry(float distance, float width);
+    float getDistancePerTick();
+    float getTrackWidth();
+
+    void setWheelCalibration(WheelCalibration calibration);
+    WheelCalibration getWheelCalibration();
+    void setCalibrationSquare(float side);
+    bool startCalibrationRun(bool clockwise);
+    bool isCalibrationRunning();
+    void addCalibrationRun(bool clockwise, float errorX, float errorY);
+    bool applyCalibration();
+
+    StoredParameters getParameters();
+    void setParameters(const StoredParameters &parameters);
+    void saveParameters();
+    bool loadParameters();
+    void savePose();
+    bool loadPose();
+
+    Integrator getIntegrator();
+    void setIntegrator(Integrator method);
+
+    void setClock(unsigned long (*clock)());
+    unsigned long getTime();
+
     bool isInverted();
     void setInverted(bool invert);
 
-    namespace {
-        extern Vector position;
-        extern Vector target;
-        extern bool followingTarget;
+    void setPoseFilterEnabled(bool enabled);
+    bool isPoseFilterEnabled();
+    void resetPoseFilter(float positionVariance, float orientationVariance);
+    void setOdometryNoise(float distance, float rotation, float drift);
+    Matrix<3, 3> getPoseCovariance();
+
+    bool addWall(float x1, float y1, float x2, float y2);
+    void clearWalls();
 
-        extern float followAngularVelocityScale;
-        extern float followVelocity;
-        extern float curveTightness;
+    bool correctRange(const RangeSensor &sensor, float range);
+    void setSonarMount(uint8_t id, RangeSensor sensor);
+    void setIRMount(uint8_t id, RangeSensor sensor);
+    bool correctWithSonar(uint8_t id);
+    bool correctWithIR(uint8_t id);
+    float irToRange(uint16_t raw);
 
+#ifndef ROBUS_POSITION_NO_MAP
+    bool mapRange(const RangeSensor &sensor, float range);
+    bool mapWithSonar(uint8_t id);
+    bool mapWithIR(uint8_t id);
+    OccupancyGrid &getOccupancyGrid();
+#endif
+
+#ifdef ROBUS_POSITION_RECORDER
+    void startRecording();
+    void stopRecording();
+    bool isRecording();
+    uint16_t getRecordCount();
+    void dumpRecording();
+    void startReplay(const RecordEntry &entry);
+    void replayUpdate(const RecordEntry &entry, float dt);
+#endif
+
+#ifndef ROBUS_POSITION_NO_MAP
+    PlanResult planPath(float x, float y);
+    bool isPlanActive();
+    bool replanIfBlocked();
+    bool reportObstacle(float x, float y);
+    bool reportBumper(uint8_t id);
+#endif
+
+    namespace {
+        extern PositionOdometry odometry;
+        extern PositionFollower follower;
         extern bool inverted;
+        extern OdometrySource odometrySource;
+#ifndef ROBUS_POSITION_NO_POSE_HISTORY
+        extern PoseHistory poseHistory;
+#endif
+        extern unsigned long (*timeSource)();
+        extern PoseSnapshot snapshot;
+        extern unsigned long lastUpdateTime;
+        extern bool updated;
+        extern volatile bool fixedRate;
+        extern volatile bool fixedRateBusy;
+        extern uint16_t fixedRateFrequency;
+        extern uint16_t fixedRateTicks;
+        extern LoopStatistics loopStatistics;
+        extern PoseFilter poseFilter;
+        extern bool poseFilterEnabled;
+        extern float orientationCorrection;
+        extern RangeSensor sonarMounts[SONAR_COUNT];
+        extern RangeSensor irMounts[IR_COUNT];
+#ifndef ROBUS_POSITION_NO_MAP
+        extern OccupancyGrid occupancyGrid;
+#endif
+        extern Umbmark umbmark;
+        extern uint8_t calibrationLeg;
+        extern bool calibrationClockwise;
+        extern Pose calibrationStart;
+        extern ParameterStore parameterStore;
+#ifdef ROBUS_POSITION_RECORDER
+        extern Recorder recorder;
+#endif
+#ifndef ROBUS_POSITION_NO_MAP
+        extern GridPlanner planner;
+        extern bool planActive;
+        extern float planGoalX;
+        extern float planGoalY;
+#endif
     }
 }
 
@@ -0,0 +1,54 @@
+#include "SpeedCurve.h"
+
+namespace RobusPosition
+{
+    SpeedCurve::SpeedCurve(float tightness) {
+        // cos(e)^k ~ exp(-k e^2 / 2) falls under 2^-16 past sqrt(2 * 16 ln 2 / k).
+        float span = HALF_PI;
+        if (tightness > 0) {
+            float fade = sqrt(22.18f / tightness);
+            if (fade < span) {
+                span = fade;
+            }
+        }
+        stepsPerRadian_ = SPEED_CURVE_STEPS / span;
+        fixedStepsPerRadian_ = FixedPoint::Fixed(stepsPerRadian_).raw;
+
+        for (uint8_t i = 0; i <= SPEED_CURVE_STEPS; i++) {
+            // cos(HALF_PI) rounds to -4.4e-8 in float, and pow() of a negative base is NaN for fractional tightness.
+            float factor = pow(fmax(0.0f, cos(i * span / SPEED_CURVE_STEPS)), tightness);
+            table_[i] = (uint16_t) (factor * 65535 + 0.5f);
+        }
+        if (span < HALF_PI) {
+            // The curve is negligible past the table, end it at zero so interpolation meets the cut.
+            table_[SPEED_CURVE_STEPS] = 0;
+        }
+    }
+
+    float SpeedCurve::evaluate(float error) const {
+        float position = fabs(error) * stepsPerRadian_;
+        if (position >= SPEED_CURVE_STEPS) {
+            return 0;
+        }
+        uint8_t index = (uint8_t) position;
+        float low = table_[index];
+        float high = table_[index + 1];
+        return (low + (high - low) * (position - index)) * (1.0f / 65535);
+    }
+
+    FixedPoint::Fixed SpeedCurve::evaluate(FixedPoint::Fixed error) const {
+        using FixedPoint::Fixed;
+
+        Fixed position = (error < 0 ? -error : error) * Fixed::fromRaw(fixedStepsPerRadian_);
+        if (position >= Fixed(SPEED_CURVE_STEPS)) {
+            return Fixed();
+        }
+        uint8_t index = position.raw >> 16;
+        int32_t fraction = position.raw & 0xFFFF;
+        int32_t low = table_[index];
+        int32_t high = table_[index + 1];
+        // 65535 stands for 1, close enough to the 65536 of Q16.16. The step of a loose curve near
+        // its cut can reach 65535, times the fraction it would overflow a plain 32-bit product.
+        return Fixed::fromRaw(low) + Fixed::fromRaw(high - low) * Fixed::fromRaw(fraction);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef SPEED_CURVE_H
+#define SPEED_CURVE_H
+
+#include <Arduino.h>
+#include "FixedPoint.h"
+
+#ifndef SPEED_CURVE_STEPS
+#define SPEED_CURVE_STEPS 64
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Speed factor of the target follower against the heading error, as a lookup table.
+     *
+     * Tabulates cos(error)^tightness once, so each update costs one interpolated read instead of
+     * a pow(). The table only spans the errors where the factor is above 2^-16, which is much
+     * narrower than [0, PI/2] for tight curves, so the steps stay fine where the curve is steep.
+     */
+    class SpeedCurve
+    {
+      public:
+        /**
+         * @brief Build the table for a curve tightness.
+         * @param tightness The exponent of the cosine, 0 for a flat curve.
+         */
+        explicit SpeedCurve(float tightness = 0);
+
+        /**
+         * @brief Get the speed factor for a heading error.
+         * @param error The heading error in radians, in the range [-PI, PI].
+         * @return The factor, in the range [0, 1].
+         */
+        float evaluate(float error) const;
+
+        /**
+         * @brief Q16.16 version of evaluate(), integer operations only.
+         */
+        FixedPoint::Fixed evaluate(FixedPoint::Fixed error) const;
+
+      private:
+        uint16_t table_[SPEED_CURVE_STEPS + 1]; // Factor * 65535 at each step
+        float stepsPerRadian_;
+        int32_t fixedStepsPerRadian_; // stepsPerRadian_ in Q16.16
+    };
+}
+
+#endif // SPEED_CURVE_H
@@ -0,0 +1,38 @@
+#include "WaypointQueue.h"
+
+namespace RobusPosition
+{
+    WaypointQueue::WaypointQueue() {
+        clear();
+    }
+
+    bool WaypointQueue::push(float x, float y) {
+        if (isFull()) {
+            return false;
+        }
+        uint8_t slot = (first_ + count_) % WAYPOINT_QUEUE_SIZE;
+        x_[slot] = x;
+        y_[slot] = y;
+        count_++;
+        return true;
+    }
+
+    void WaypointQueue::pop() {
+        if (isEmpty()) {
+            return;
+        }
+        first_ = (first_ + 1) % WAYPOINT_QUEUE_SIZE;
+        count_--;
+    }
+
+    void WaypointQueue::clear() {
+        first_ = 0;
+        count_ = 0;
+    }
+
+    void WaypointQueue::get(uint8_t i, float &x, float &y) const {
+        uint8_t slot = (first_ + i) % WAYPOINT_QUEUE_SIZE;
+        x = x_[slot];
+        y = y_[slot];
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef WAYPOINT_QUEUE_H
+#define WAYPOINT_QUEUE_H
+
+#include <Arduino.h>
+
+#ifndef WAYPOINT_QUEUE_SIZE
+#define WAYPOINT_QUEUE_SIZE 16
+#endif
+
+namespace RobusPosition
+{
+    /**
+     * @brief Statically sized first-in first-out queue of waypoints.
+     */
+    class WaypointQueue
+    {
+      public:
+        WaypointQueue();
+
+        /**
+         * @brief Append a waypoint at the end of the queue.
+         * @param x The X-coordinate of the waypoint.
+         * @param y The Y-coordinate of the waypoint.
+         * @return false if the queue is full.
+         */
+        bool push(float x, float y);
+
+        /**
+         * @brief Remove the first waypoint of the queue.
+         */
+        void pop();
+
+        /**
+         * @brief Remove all the waypoints.
+         */
+        void clear();
+
+        /**
+         * @brief Get a waypoint of the queue.
+         * @param i Index from the first waypoint, in [0, count()[.
+         * @param x Receives the X-coordinate of the waypoint.
+         * @param y Receives the Y-coordinate of the waypoint.
+         */
+        void get(uint8_t i, float &x, float &y) const;
+
+        /**
+         * @brief Get the number of waypoints in the queue.
+         * @return The number of waypoints.
+         */
+        uint8_t count() const { return count_; }
+
+        bool isEmpty() const { return count_ == 0; }
+        bool isFull() const { return count_ == WAYPOINT_QUEUE_SIZE; }
+
+      private:
+        float x_[WAYPOINT_QUEUE_SIZE];
+        float y_[WAYPOINT_QUEUE_SIZE];
+        uint8_t first_; // Index of the first waypoint
+        uint8_t count_; // Number of waypoints
+    };
+}
+
+#endif // WAYPOINT_QUEUE_H